@@ -0,0 +1,196 @@
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// Host side decoder of the display mirror stream.
+#include <string.h>
+#include "LCD.h"
+#include "LCDMirror.h"
+#include "LCDMirrorDecoder.h"
+
+// Parser states
+#define WAIT_SYNC       0   // Looking for the keyframe opcode
+#define WAIT_L          1
+#define WAIT_K          2
+#define KEY_HEADER      3   // lines, cols, control, entry, flags
+#define KEY_DDRAM       4
+#define KEY_CGRAM       5
+#define OPCODE          6
+#define RUN_ADDR        7
+#define RUN_DATA        8
+#define VALUE           9   // Argument of control, entry and shift
+
+// Same layout as LCD_rowAddress
+static uint8_t rowAddress(const struct LCDMirrorDecoder *d, uint8_t row)
+{
+    static const uint8_t offsetsDef[]   = { 0x00, 0x40, 0x14, 0x54 };
+    static const uint8_t offsetsLarge[] = { 0x00, 0x40, 0x10, 0x50 };
+
+    if (d->cols == 16 && d->numlines == 4)
+        return offsetsLarge[row & 3];
+    return offsetsDef[row & 3];
+}
+
+// DDRAM length of a line, 40 cells on LCDs of more than one line
+static uint8_t lineLength(const struct LCDMirrorDecoder *d)
+{
+    return (d->numlines > 1) ? LCD_MIRROR_DDRAM_SIZE / 2 : LCD_MIRROR_DDRAM_SIZE;
+}
+
+// DDRAM address of a position of the keyframe
+static uint8_t keyAddress(const struct LCDMirrorDecoder *d, uint16_t pos)
+{
+    if (d->numlines > 1 && pos >= LCD_MIRROR_DDRAM_SIZE / 2)
+        return 0x40 + (pos - LCD_MIRROR_DDRAM_SIZE / 2);
+    return (uint8_t)pos;
+}
+
+static void moveDisplay(struct LCDMirrorDecoder *d, bool right)
+{
+    uint8_t len = lineLength(d);
+
+    if (right)
+        d->shift = (d->shift + 1 == len) ? 0 : d->shift + 1;
+    else
+        d->shift = (d->shift == 0) ? len - 1 : d->shift - 1;
+}
+
+static void lostSync(struct LCDMirrorDecoder *d)
+{
+    d->synced = false;
+    d->state = WAIT_SYNC;
+}
+
+void LCDMirror_initDecoder(struct LCDMirrorDecoder *d)
+{
+    memset(d, 0, sizeof(*d));
+    memset(d->ddram, ' ', sizeof(d->ddram));
+    d->state = WAIT_SYNC;
+}
+
+void LCDMirror_decode(struct LCDMirrorDecoder *d, uint8_t value)
+{
+    switch (d->state) {
+    case WAIT_SYNC:
+        if (value == LCD_MIRROR_KEYFRAME)
+            d->state = WAIT_L;
+        break;
+
+    case WAIT_L:
+        d->state = (value == 'L') ? WAIT_K : WAIT_SYNC;
+        break;
+
+    case WAIT_K:
+        d->state = (value == 'K') ? KEY_HEADER : WAIT_SYNC;
+        d->pos = 0;
+        break;
+
+    case KEY_HEADER:
+        switch (d->pos++) {
+        case 0: d->numlines = value; break;
+        case 1: d->cols = value; break;
+        case 2: d->control = value; break;
+        case 3: d->entry = value; break;
+        case 4: d->op = value; break;  // Flags
+        case 5:
+            d->shift = value;
+            d->pos = 0;
+            if (d->numlines == 0 || d->numlines > 4 || d->cols == 0 || d->cols > lineLength(d) ||
+                d->shift >= lineLength(d))
+                lostSync(d);
+            else
+                d->state = KEY_DDRAM;
+            break;
+        }
+        break;
+
+    case KEY_DDRAM:
+        d->ddram[keyAddress(d, d->pos)] = value;
+        if (++d->pos == LCD_MIRROR_DDRAM_SIZE) {
+            d->pos = 0;
+            if (d->op & 1) {
+                d->state = KEY_CGRAM;
+            } else {
+                d->state = OPCODE;
+                d->synced = true;
+            }
+        }
+        break;
+
+    case KEY_CGRAM:
+        d->cgram[d->pos] = value;
+        if (++d->pos == 64) {
+            d->state = OPCODE;
+            d->synced = true;
+        }
+        break;
+
+    case OPCODE:
+        d->op = value;
+        if (value == LCD_MIRROR_KEYFRAME) {
+            d->state = WAIT_L;
+        } else if (value == LCD_MIRROR_CLEAR) {
+            memset(d->ddram, ' ', sizeof(d->ddram));
+            d->entry |= LCD_ENTRYLEFT;
+            d->shift = 0;
+        } else if (value == LCD_MIRROR_HOME) {
+            d->shift = 0;
+        } else if (value >= LCD_MIRROR_CONTROL && value <= LCD_MIRROR_SHIFT) {
+            d->state = VALUE;
+        } else if ((value & 0x3F) != 0 && value < LCD_MIRROR_CONTROL) {
+            d->len = value & 0x3F;
+            d->state = RUN_ADDR;
+        } else {
+            lostSync(d);
+        }
+        break;
+
+    case RUN_ADDR:
+        d->addr = value;
+        d->pos = 0;
+        d->state = RUN_DATA;
+        break;
+
+    case RUN_DATA:
+        if (d->op & LCD_MIRROR_CGRAM) {
+            d->cgram[(d->addr + d->pos) & 0x3F] = value;
+        } else {
+            d->ddram[(d->addr + d->pos) & 0x7F] = value;
+            if (d->entry & LCD_ENTRYSHIFTINCREMENT)
+                moveDisplay(d, !(d->entry & LCD_ENTRYLEFT));
+        }
+        if (++d->pos == d->len)
+            d->state = OPCODE;
+        break;
+
+    case VALUE:
+        if (d->op == LCD_MIRROR_CONTROL)
+            d->control = value;
+        else if (d->op == LCD_MIRROR_ENTRY)
+            d->entry = value;
+        else
+            moveDisplay(d, (value & LCD_MOVERIGHT) != 0);
+        d->state = OPCODE;
+        break;
+    }
+}
+
+uint8_t LCDMirror_cell(const struct LCDMirrorDecoder *d, uint8_t col, uint8_t row)
+{
+    if (row >= d->numlines || col >= d->cols)
+        return ' ';
+    return d->ddram[rowAddress(d, row) + col];
+}
+
+uint8_t LCDMirror_shown(const struct LCDMirrorDecoder *d, uint8_t col, uint8_t row)
+{
+    uint8_t len = lineLength(d);
+    uint8_t base, pos;
+
+    if (row >= d->numlines || col >= d->cols)
+        return ' ';
+
+    // Rows 2 and 3 continue the lines of rows 0 and 1
+    base = rowAddress(d, row);
+    pos = ((base & 0x3F) + col + len - d->shift) % len;
+    return d->ddram[(base & 0x40) + pos];
+}
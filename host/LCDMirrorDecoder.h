@@ -0,0 +1,80 @@
+// ---------------------------------------------------------------------------
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// This software is furnished "as is", without technical support, and with no
+// warranty, express or implied, as to its usefulness for any purpose.
+//
+// Thread Safe: No
+//
+// @file LCDMirrorDecoder.h
+// Rebuilds the screen from the delta stream of LCDMirror.h.
+//
+// @brief
+// Host side counterpart of the display mirror. Bytes are fed one at a time
+// as they arrive, the decoder ignores everything until the first keyframe
+// and goes back to waiting for one when it finds an invalid record.
+// ---------------------------------------------------------------------------
+#ifndef _LCD_MIRROR_DECODER_H_
+#define _LCD_MIRROR_DECODER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*!
+ \brief   Screen rebuilt by the decoder
+ */
+struct LCDMirrorDecoder {
+    uint8_t ddram[128];
+    uint8_t cgram[64];
+    uint8_t numlines;
+    uint8_t cols;
+    uint8_t control;
+    uint8_t entry;
+
+    /** Display shift in cells to the right, 0 to the line length - 1 */
+    uint8_t shift;
+
+    /** A keyframe has been received and the stream is in sync */
+    bool synced;
+
+    /** Parser state */
+    uint8_t state;
+    uint8_t op;
+    uint8_t addr;
+    uint16_t pos;
+    uint16_t len;
+};
+
+/*!
+\brief   Initializes a decoder, waiting for a keyframe.
+\param      d     The decoder
+*/
+void LCDMirror_initDecoder(struct LCDMirrorDecoder *d);
+
+/*!
+\brief   Feeds a byte of the stream.
+\param      d     The decoder
+\param      value Byte received
+*/
+void LCDMirror_decode(struct LCDMirrorDecoder *d, uint8_t value);
+
+/*!
+\brief   Character shown at a cell, ignoring the display shift.
+\param      d     The decoder
+\param      col   Column
+\param      row   Row
+\return     Character code
+*/
+uint8_t LCDMirror_cell(const struct LCDMirrorDecoder *d, uint8_t col, uint8_t row);
+
+/*!
+\brief   Character shown at a cell, with the display shift applied.
+\param      d     The decoder
+\param      col   Column
+\param      row   Row
+\return     Character code
+*/
+uint8_t LCDMirror_shown(const struct LCDMirrorDecoder *d, uint8_t col, uint8_t row);
+
+#endif
@@ -0,0 +1,30 @@
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// Simulated clock for host builds of the PIC LCD library.
+#include <stdio.h>
+#include "LCDSim.h"
+
+uint64_t LCDSim_time;
+uint8_t LCDSim_eeprom[LCDSIM_EEPROM_SIZE];
+
+static uint16_t (*timerSource)(void);
+
+void LCDSim_delay(uint32_t ns)
+{
+    LCDSim_time += ns;
+}
+
+uint16_t LCDSim_timerNow(void)
+{
+    if (timerSource != NULL)
+        return timerSource();
+
+    LCDSim_time += LCDSIM_TIMER_READ_NS;
+    return (uint16_t)(LCDSim_time / 1000);
+}
+
+void LCDSim_setTimer(uint16_t (*timer)(void))
+{
+    timerSource = timer;
+}
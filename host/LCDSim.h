@@ -0,0 +1,62 @@
+// ---------------------------------------------------------------------------
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// This software is furnished "as is", without technical support, and with no
+// warranty, express or implied, as to its usefulness for any purpose.
+//
+// Thread Safe: No
+//
+// @file LCDSim.h
+// Simulated clock and EEPROM for host builds of the PIC LCD library.
+// ---------------------------------------------------------------------------
+#ifndef _LCD_SIM_H_
+#define _LCD_SIM_H_
+
+#include <stdint.h>
+
+/*!
+ @defined
+ @abstract   Time it takes to read the LCD timer.
+ @discussion Every call to LCDSim_timerNow advances the simulated clock by
+ this many nanoseconds, so busy waits on the timer make progress.
+ */
+#define LCDSIM_TIMER_READ_NS    500
+
+/*!
+ @defined
+ @abstract   Size of the simulated data EEPROM.
+ */
+#define LCDSIM_EEPROM_SIZE      256
+
+/** Simulated time in nanoseconds since the start of the program */
+extern uint64_t LCDSim_time;
+
+/** Contents of the simulated data EEPROM, read with eeprom_read */
+extern uint8_t LCDSim_eeprom[LCDSIM_EEPROM_SIZE];
+
+/*!
+\brief   Advances the simulated clock.
+\param      ns Nanoseconds to advance
+*/
+void LCDSim_delay(uint32_t ns);
+
+/*!
+\brief   Reads the LCD timer.
+\details Returns the free running 16 bit microsecond counter used by
+LCD_USE_TIMER. By default it is derived from the simulated clock, another
+source can be installed with LCDSim_setTimer.
+*/
+uint16_t LCDSim_timerNow(void);
+
+/*!
+\brief   Replaces the timer source read by LCDSim_timerNow.
+\details The source must advance on its own (e.g. by calling LCDSim_delay),
+otherwise the drivers would wait forever. Pass NULL to restore the default
+source.
+
+\param      timer Function returning the timer value in microseconds
+*/
+void LCDSim_setTimer(uint16_t (*timer)(void));
+
+#endif
@@ -0,0 +1,573 @@
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// Simulated LCD bus and HD44780 timing checker for host builds.
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include "LCD.h"
+
+#define SIG(s)      ((uint16_t)1 << (s))
+#define DATA_MASK   ((uint16_t)0xFF << LCDSIM_D0)
+
+volatile uint8_t LCDSim_sr595;
+uint16_t LCDSim_violations;
+uint8_t LCDSim_ddram[LCDSIM_DDRAM_SIZE];
+uint8_t LCDSim_control;
+
+// Wiring
+static struct {
+    volatile uint8_t *port;
+    uint8_t mask;
+} pins[LCDSIM_SIGNALS];
+
+static struct {
+    volatile uint8_t *port;
+    uint8_t data, clock, latch;     // Pin masks
+    uint8_t shift[LCD_CHAIN_MAX];   // Cascaded registers, the first one is fed by data
+    uint8_t count;
+    uint8_t watch;                  // Register whose outputs are LCDSim_sr595
+    uint8_t last;
+} sr;
+
+// Input register of the data port, driven during reads
+static volatile uint8_t *readPort;
+
+static uint16_t levels;
+static uint64_t changedAt[LCDSIM_SIGNALS];
+
+// Model of the HD44780
+static bool checking;
+static bool eightBit;
+static bool lowNibble;
+static uint8_t highNibble;
+static uint8_t initSets;
+static bool seenRise, seenFall;
+static uint64_t powerOn, eRise, eFall, busyUntil;
+static const char *busyWith;
+static uint8_t ac;
+static bool cgram, increment, twoLines;
+
+static void (*reportFn)(uint64_t time, const char *what);
+
+// Value change dump: the LCD signals, then the 74HC595 inputs
+#define VCD_SER     LCDSIM_SIGNALS
+#define VCD_SCK     (LCDSIM_SIGNALS + 1)
+#define VCD_RCK     (LCDSIM_SIGNALS + 2)
+#define VCD_SIGNALS (LCDSIM_SIGNALS + 3)
+
+static FILE *vcd;
+static uint64_t vcdTime;
+static uint16_t vcdLevels;
+static struct LCDHook traceHook;
+
+static const char * const names[VCD_SIGNALS] = {
+    "RS", "RW", "E", "D0", "D1", "D2", "D3", "D4", "D5", "D6", "D7", "SER", "SCK", "RCK"
+};
+
+static void violation(const char *fmt, ...)
+{
+    char what[120];
+    va_list args;
+
+    va_start(args, fmt);
+    vsnprintf(what, sizeof(what), fmt, args);
+    va_end(args);
+
+    LCDSim_violations++;
+
+    if (reportFn != NULL)
+        reportFn(LCDSim_time, what);
+    else
+        fprintf(stderr, "LCDSim %llu.%03u us: %s\n", (unsigned long long)(LCDSim_time / 1000), (unsigned)(LCDSim_time % 1000), what);
+}
+
+static uint16_t sample(void)
+{
+    uint16_t v = 0;
+    uint8_t i;
+
+    for (i = 0; i < LCDSIM_SIGNALS; i++) {
+        if (pins[i].port != NULL && (*pins[i].port & pins[i].mask))
+            v |= SIG(i);
+    }
+    return v;
+}
+
+// Data lines the LCD latches in its current interface mode
+static uint16_t dataLines(void)
+{
+    uint16_t mask = eightBit ? DATA_MASK : ((uint16_t)0xF0 << LCDSIM_D0);
+    uint8_t i;
+
+    for (i = LCDSIM_D0; i < LCDSIM_SIGNALS; i++) {
+        if (pins[i].port == NULL)
+            mask &= ~SIG(i);
+    }
+    return mask;
+}
+
+// Busy time of an instruction written to the instruction register
+static uint32_t execTime(uint8_t value)
+{
+    if ((value & 0xE0) == LCD_FUNCTIONSET) {
+        eightBit = (value & LCD_8BITMODE) != 0;
+        lowNibble = false;
+
+        switch (initSets) {
+        case 0:
+            initSets++;
+            busyWith = "first function set of the init sequence";
+            return LCDSIM_T_INIT1;
+        case 1:
+            initSets++;
+            busyWith = "second function set of the init sequence";
+            return LCDSIM_T_INIT2;
+        }
+    } else if (value == LCD_CLEARDISPLAY || (value & 0xFE) == LCD_RETURNHOME) {
+        busyWith = "clear display or return home";
+        return LCDSIM_T_HOME;
+    }
+
+    busyWith = "previous instruction";
+    return LCDSIM_T_EXEC;
+}
+
+// Move the address counter after a data access or a cursor shift
+static void step(bool right)
+{
+    if (cgram) {
+        ac = (ac + (right ? 1 : -1)) & 0x3F;
+    } else if (right) {
+        ac++;
+        if (twoLines)
+            ac = (ac == 0x28) ? 0x40 : (ac == 0x68) ? 0x00 : ac;
+        else if (ac == 0x50)
+            ac = 0x00;
+    } else if (twoLines) {
+        ac = (ac == 0x40) ? 0x27 : (ac == 0x00) ? 0x67 : ac - 1;
+    } else {
+        ac = (ac == 0x00) ? 0x4F : ac - 1;
+    }
+}
+
+// DDRAM, address counter and display control of the model
+static void memory(bool rs, bool rw, uint8_t value)
+{
+    if (rs) {
+        if (!rw && !cgram)
+            LCDSim_ddram[ac] = value;
+        step(increment);
+    } else if (rw) {
+        return;     // Busy flag read
+    } else if (value & LCD_SETDDRAMADDR) {
+        ac = value & 0x7F;
+        cgram = false;
+    } else if (value & LCD_SETCGRAMADDR) {
+        ac = value & 0x3F;
+        cgram = true;
+    } else if (value & LCD_FUNCTIONSET) {
+        twoLines = (value & LCD_2LINE) != 0;
+    } else if (value & LCD_CURSORSHIFT) {
+        if (!(value & LCD_DISPLAYMOVE))
+            step((value & LCD_MOVERIGHT) != 0);
+    } else if (value & LCD_DISPLAYCONTROL) {
+        LCDSim_control = value & 0x07;
+    } else if (value & LCD_ENTRYMODESET) {
+        increment = (value & LCD_ENTRYLEFT) != 0;
+    } else if (value & LCD_RETURNHOME) {
+        ac = 0;
+        cgram = false;
+    } else if (value == LCD_CLEARDISPLAY) {
+        memset(LCDSim_ddram, ' ', sizeof(LCDSim_ddram));
+        ac = 0;
+        cgram = false;
+        increment = true;
+    }
+}
+
+// The LCD executes an instruction or a data access
+static void execute(uint64_t now, bool rs, bool rw, uint8_t value)
+{
+    memory(rs, rw, value);
+
+    if (!rw && !rs) {
+        busyUntil = now + execTime(value);
+    } else if (rs) {
+        busyUntil = now + LCDSIM_T_EXEC;
+        busyWith = rw ? "previous data read" : "previous data write";
+    }
+}
+
+// E fell, the LCD latches the data lines
+static void latch(uint64_t now)
+{
+    bool rs = (levels & SIG(LCDSIM_RS)) != 0;
+    bool rw = (levels & SIG(LCDSIM_RW)) != 0;
+    uint8_t value = (uint8_t)((levels & DATA_MASK) >> LCDSIM_D0);
+
+    if (!eightBit && lowNibble) {
+        // The access was checked on its first nibble
+        lowNibble = false;
+        execute(now, rs, rw, highNibble | (value >> 4));
+        return;
+    }
+
+    if (eightBit && !rs && !rw && value == 0x00)
+        return;     // No instruction, e.g. the enable pulse of LCD_initShiftReg
+
+    // Reading the busy flag is the only access allowed while busy
+    if (!rw || rs) {
+        if (now < powerOn + LCDSIM_T_POWERON)
+            violation("%s %llu us after power on, needs %lu us", rw ? "read" : "write",
+                      (unsigned long long)((now - powerOn) / 1000), (unsigned long)(LCDSIM_T_POWERON / 1000));
+        if (now < busyUntil)
+            violation("%s %s latched %llu ns early, busy with the %s", rs ? "data" : "instruction", rw ? "read" : "write",
+                      (unsigned long long)(busyUntil - now), busyWith);
+    }
+
+    if (eightBit) {
+        execute(now, rs, rw, value);
+    } else {
+        highNibble = value & 0xF0;
+        lowNibble = true;
+    }
+}
+
+// E rose in a read, the LCD drives the busy flag. The address counter and
+// the RAM are not modeled and read 0.
+static void drive(uint64_t now)
+{
+    uint8_t value = 0x00;
+    uint8_t i;
+
+    if (readPort == NULL)
+        return;
+
+    if (!(levels & SIG(LCDSIM_RS)) && now < busyUntil)
+        value = 0x80;
+    if (!eightBit && lowNibble)
+        value <<= 4;
+
+    for (i = 0; i < 8; i++) {
+        if (pins[LCDSIM_D0 + i].port == NULL)
+            continue;
+        if (value & (1 << i))
+            *readPort |= pins[LCDSIM_D0 + i].mask;
+        else
+            *readPort &= ~pins[LCDSIM_D0 + i].mask;
+    }
+}
+
+static void evaluate(void)
+{
+    uint64_t now = LCDSim_time;
+    uint16_t v = sample();
+    uint16_t diff = v ^ levels;
+    uint16_t lines;
+    uint8_t i;
+
+    if (diff == 0)
+        return;
+
+    for (i = 0; i < LCDSIM_SIGNALS; i++) {
+        if (i == LCDSIM_E || !(diff & SIG(i)))
+            continue;
+
+        if (checking && seenFall && !(levels & SIG(LCDSIM_E))) {
+            uint32_t hold = (i == LCDSIM_RS || i == LCDSIM_RW) ? LCDSIM_T_AH : LCDSIM_T_H;
+            if (now - eFall < hold)
+                violation("%s changed %llu ns after E fell, hold time is %lu ns", names[i],
+                          (unsigned long long)(now - eFall), (unsigned long)hold);
+        }
+        changedAt[i] = now;
+    }
+
+    levels = v;
+    if (!(diff & SIG(LCDSIM_E)))
+        return;
+    changedAt[LCDSIM_E] = now;
+
+    if (v & SIG(LCDSIM_E)) {
+        if (checking) {
+            if (seenRise && now - eRise < LCDSIM_T_CYCE)
+                violation("enable cycle %llu ns, needs %lu ns", (unsigned long long)(now - eRise), (unsigned long)LCDSIM_T_CYCE);
+            for (i = LCDSIM_RS; i <= LCDSIM_RW; i++) {
+                if (pins[i].port != NULL && now - changedAt[i] < LCDSIM_T_AS)
+                    violation("%s set up %llu ns before E rose, needs %lu ns", names[i],
+                              (unsigned long long)(now - changedAt[i]), (unsigned long)LCDSIM_T_AS);
+            }
+            if (v & SIG(LCDSIM_RW))
+                drive(now);
+        }
+        seenRise = true;
+        eRise = now;
+    } else {
+        if (checking) {
+            if (seenRise && now - eRise < LCDSIM_T_PWEH)
+                violation("enable pulse %llu ns, needs %lu ns", (unsigned long long)(now - eRise), (unsigned long)LCDSIM_T_PWEH);
+            if (!(v & SIG(LCDSIM_RW))) {
+                lines = dataLines();
+                for (i = LCDSIM_D0; i < LCDSIM_SIGNALS; i++) {
+                    if ((lines & SIG(i)) && now - changedAt[i] < LCDSIM_T_DSW)
+                        violation("%s set up %llu ns before E fell, needs %lu ns", names[i],
+                                  (unsigned long long)(now - changedAt[i]), (unsigned long)LCDSIM_T_DSW);
+                }
+            }
+            latch(now);
+        }
+        seenFall = true;
+        eFall = now;
+    }
+}
+
+static void update595(void)
+{
+    uint8_t p = *sr.port;
+    uint8_t rising = p & ~sr.last;
+    uint8_t i;
+
+    // Each register takes the bit falling out of the previous one
+    if (rising & sr.clock) {
+        for (i = sr.count - 1; i > 0; i--)
+            sr.shift[i] = (sr.shift[i] >> 1) | ((sr.shift[i - 1] & 0x01) ? 0x80 : 0x00);
+        sr.shift[0] = (sr.shift[0] >> 1) | ((p & sr.data) ? 0x80 : 0x00);
+    }
+    if (rising & sr.latch)
+        LCDSim_sr595 = sr.shift[sr.watch];
+
+    sr.last = p;
+}
+
+static uint16_t vcdSample(void)
+{
+    uint16_t v = levels;
+
+    if (sr.port != NULL) {
+        if (*sr.port & sr.data)
+            v |= SIG(VCD_SER);
+        if (*sr.port & sr.clock)
+            v |= SIG(VCD_SCK);
+        if (*sr.port & sr.latch)
+            v |= SIG(VCD_RCK);
+    }
+    return v;
+}
+
+static bool vcdConnected(uint8_t i)
+{
+    return (i < LCDSIM_SIGNALS) ? pins[i].port != NULL : sr.port != NULL;
+}
+
+// Start a new time step if the clock moved since the last one
+static void vcdStamp(void)
+{
+    if (LCDSim_time != vcdTime) {
+        fprintf(vcd, "#%llu\n", (unsigned long long)LCDSim_time);
+        vcdTime = LCDSim_time;
+    }
+}
+
+static void vcdUpdate(void)
+{
+    uint16_t v = vcdSample();
+    uint16_t diff = v ^ vcdLevels;
+    uint8_t i;
+
+    if (diff == 0)
+        return;
+
+    vcdStamp();
+    for (i = 0; i < VCD_SIGNALS; i++) {
+        if ((diff & SIG(i)) && vcdConnected(i))
+            fprintf(vcd, "%c%c\n", (v & SIG(i)) ? '1' : '0', '!' + i);
+    }
+    vcdLevels = v;
+}
+
+void LCDSim_portChanged(volatile uint8_t *port)
+{
+    LCDSim_time += LCDSIM_PORT_WRITE_NS;
+
+    if (port == sr.port)
+        update595();
+    evaluate();
+
+    if (vcd != NULL)
+        vcdUpdate();
+}
+
+void LCDSim_connect(uint8_t signal, volatile uint8_t *port, uint8_t bit)
+{
+    pins[signal].port = port;
+    pins[signal].mask = 1 << bit;
+    levels = sample();
+}
+
+void LCDSim_connect595(volatile uint8_t *port, uint8_t data, uint8_t clock, uint8_t latch)
+{
+    sr.port = port;
+    sr.data = 1 << data;
+    sr.clock = 1 << clock;
+    sr.latch = 1 << latch;
+    sr.last = *port;
+    sr.count = 1;
+    sr.watch = 0;
+}
+
+static void disconnectAll(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < LCDSIM_SIGNALS; i++)
+        pins[i].port = NULL;
+    sr.port = NULL;
+    readPort = NULL;
+}
+
+void LCDSim_wireParallel(struct LCD *lcd)
+{
+    uint8_t i;
+
+    disconnectAll();
+
+    if (lcd->displayfunction & LCD_8BITMODE) {
+        for (i = 0; i < 8; i++)
+            LCDSim_connect(LCDSIM_D0 + i, lcd->i.pi.lcd_dport, i);
+    } else {
+        for (i = 0; i < 4; i++)
+#ifndef LCD_USE_UPPER_NIBBLE
+            LCDSim_connect(LCDSIM_D0 + 4 + i, lcd->i.pi.lcd_dport, i);
+#else
+            LCDSim_connect(LCDSIM_D0 + 4 + i, lcd->i.pi.lcd_dport, 4 + i);
+#endif
+    }
+
+    LCDSim_connect(LCDSIM_RS, lcd->i.pi.lcd_cport, lcd->i.pi.rs_pin);
+    LCDSim_connect(LCDSIM_E, lcd->i.pi.lcd_cport, lcd->i.pi.enable_pin);
+    if (lcd->read != NULL) {
+        LCDSim_connect(LCDSIM_RW, lcd->i.pi.lcd_cport, lcd->i.pi.rw_pin);
+        readPort = lcd->i.pi.lcd_dread;
+    }
+}
+
+void LCDSim_wireShiftReg(struct LCD *lcd)
+{
+    volatile uint8_t *port = lcd->i.sri.sr_port;
+    uint8_t i;
+
+    disconnectAll();
+    LCDSim_connect595(port, lcd->i.sri.srdata_pin, lcd->i.sri.srclock_pin, lcd->i.sri.strobe_pin);
+
+    if (lcd->i.sri.mode == LCD_SR_CHAIN) {
+        sr.count = lcd->i.sri.chain->count;
+        sr.watch = lcd->i.sri.index;
+    }
+
+    if (lcd->i.sri.mode == LCD_SR_8BIT) {
+        for (i = 0; i < 8; i++)
+            LCDSim_connect(LCDSIM_D0 + i, &LCDSim_sr595, i);
+        LCDSim_connect(LCDSIM_RS, port, lcd->i.sri.rs_pin);
+        LCDSim_connect(LCDSIM_E, port, lcd->i.sri.strobe_pin);
+    } else {
+        for (i = 0; i < 4; i++)
+            LCDSim_connect(LCDSIM_D0 + 4 + i, &LCDSim_sr595, i);
+        LCDSim_connect(LCDSIM_RW, &LCDSim_sr595, 5);
+        LCDSim_connect(LCDSIM_RS, &LCDSim_sr595, 6);
+        if (lcd->i.sri.mode == LCD_SR_ENABLE_STROBE)
+            LCDSim_connect(LCDSIM_E, port, lcd->i.sri.strobe_pin);
+        else
+            LCDSim_connect(LCDSIM_E, &LCDSim_sr595, 4);
+    }
+}
+
+void LCDSim_startCheck(void)
+{
+    checking = true;
+    eightBit = true;
+    lowNibble = false;
+    initSets = 0;
+    seenRise = false;
+    seenFall = false;
+    powerOn = LCDSim_time;
+    busyUntil = 0;
+    busyWith = "power on";
+    LCDSim_violations = 0;
+    memset(LCDSim_ddram, ' ', sizeof(LCDSim_ddram));
+    LCDSim_control = 0;
+    ac = 0;
+    cgram = false;
+    increment = true;
+    twoLines = false;
+    levels = sample();
+}
+
+void LCDSim_setReport(void (*report)(uint64_t time, const char *what))
+{
+    reportFn = report;
+}
+
+bool LCDSim_vcdOpen(const char *path)
+{
+    uint8_t i;
+
+    vcd = fopen(path, "w");
+    if (vcd == NULL)
+        return false;
+
+    fprintf(vcd, "$version LCDSim $end\n$timescale 1ns $end\n$scope module lcd $end\n");
+    for (i = 0; i < VCD_SIGNALS; i++) {
+        if (vcdConnected(i))
+            fprintf(vcd, "$var wire 1 %c %s $end\n", '!' + i, names[i]);
+    }
+    fprintf(vcd, "$var string 1 a api $end\n$var string 1 b byte $end\n");
+    fprintf(vcd, "$upscope $end\n$enddefinitions $end\n");
+
+    // Initial values
+    vcdTime = LCDSim_time;
+    vcdLevels = vcdSample();
+    fprintf(vcd, "#%llu\n$dumpvars\n", (unsigned long long)vcdTime);
+    for (i = 0; i < VCD_SIGNALS; i++) {
+        if (vcdConnected(i))
+            fprintf(vcd, "%c%c\n", (vcdLevels & SIG(i)) ? '1' : '0', '!' + i);
+    }
+    fprintf(vcd, "s- a\ns- b\n$end\n");
+
+    return true;
+}
+
+void LCDSim_vcdMarker(const char *name)
+{
+    if (vcd == NULL)
+        return;
+
+    vcdStamp();
+    fputc('s', vcd);
+    for (; *name != '\0'; name++)
+        fputc((*name == ' ') ? '_' : *name, vcd);
+    fputs(" a\n", vcd);
+}
+
+static void traceSend(struct LCDHook *hook, struct LCD *lcd, uint8_t value, uint8_t mode)
+{
+    if (vcd != NULL) {
+        vcdStamp();
+        fprintf(vcd, "s%s_%02X b\n", (mode == DATA) ? "data" : "cmd", value);
+    }
+
+    LCD_hookForward(hook, lcd, value, mode);
+}
+
+void LCDSim_vcdTrace(struct LCD *lcd)
+{
+    LCD_addHook(lcd, &traceHook, &traceSend);
+}
+
+void LCDSim_vcdClose(void)
+{
+    if (vcd == NULL)
+        return;
+
+    fclose(vcd);
+    vcd = NULL;
+}
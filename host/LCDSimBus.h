@@ -0,0 +1,207 @@
+// ---------------------------------------------------------------------------
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// This software is furnished "as is", without technical support, and with no
+// warranty, express or implied, as to its usefulness for any purpose.
+//
+// Thread Safe: No
+//
+// @file LCDSimBus.h
+// Simulated LCD bus for host builds of the PIC LCD library.
+//
+// @brief
+// The library calls LCD_portChanged after every port write, the host shim
+// routes it here. Every port write takes LCDSIM_PORT_WRITE_NS of simulated
+// time. Once the LCD pins are wired, every transition of RS, RW, E and
+// D0-D7 gets a simulated timestamp, the LCD pins can also be the outputs of
+// a simulated 74HC595 fed from the port.
+//
+// The checker models an HD44780 (interface width, nibble phase, busy time,
+// power on and the init sequence) and reports timing violations: enable
+// cycle and pulse width, RS/RW setup and hold, data setup and hold,
+// instructions latched while the controller is busy and instructions sent
+// too early after power on or during the init sequence. The model also
+// keeps the display data RAM and the display control register, so a test
+// can check what the screen shows.
+// While checking, instruction reads of an LCD wired with LCDSim_wireParallel
+// return the busy flag of the model on the data input register.
+//
+// The transitions can also be written to a Value Change Dump file to be
+// viewed with GTKWave, with markers for API calls and for every byte sent.
+// ---------------------------------------------------------------------------
+#ifndef _LCD_SIM_BUS_H_
+#define _LCD_SIM_BUS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*!
+ @defined
+ @abstract   Time of a port write in nanoseconds.
+ @discussion One instruction at 2 MIPS.
+ */
+#ifndef LCDSIM_PORT_WRITE_NS
+#define LCDSIM_PORT_WRITE_NS    500
+#endif
+
+/**
+ * \defgroup LCDSim_Signals LCD signals
+ *
+ * @{
+ */
+#define LCDSIM_RS               0
+#define LCDSIM_RW               1
+#define LCDSIM_E                2
+#define LCDSIM_D0               3   // D0 to D7 are LCDSIM_D0 + n
+#define LCDSIM_SIGNALS          11
+/** @} */
+
+/**
+ * \defgroup LCDSim_Timing HD44780 timing limits in nanoseconds
+ * \details Datasheet values for VCC 4.5 to 5.5V, define them before this
+ * header to check other parts or supplies. Set a limit to 0 to disable its
+ * check.
+ *
+ * @{
+ */
+#ifndef LCDSIM_T_CYCE
+#define LCDSIM_T_CYCE           500         // Enable cycle time
+#endif
+#ifndef LCDSIM_T_PWEH
+#define LCDSIM_T_PWEH           230         // Enable pulse width (high)
+#endif
+#ifndef LCDSIM_T_AS
+#define LCDSIM_T_AS             40          // RS, RW setup before E rises
+#endif
+#ifndef LCDSIM_T_AH
+#define LCDSIM_T_AH             10          // RS, RW hold after E falls
+#endif
+#ifndef LCDSIM_T_DSW
+#define LCDSIM_T_DSW            80          // Data setup before E falls
+#endif
+#ifndef LCDSIM_T_H
+#define LCDSIM_T_H              10          // Data hold after E falls
+#endif
+#ifndef LCDSIM_T_POWERON
+#define LCDSIM_T_POWERON        40000000UL  // Power on to the first instruction
+#endif
+#ifndef LCDSIM_T_INIT1
+#define LCDSIM_T_INIT1          4100000UL   // After the first function set
+#endif
+#ifndef LCDSIM_T_INIT2
+#define LCDSIM_T_INIT2          100000UL    // After the second function set
+#endif
+#ifndef LCDSIM_T_EXEC
+#define LCDSIM_T_EXEC           37000UL     // Execution time of most instructions
+#endif
+#ifndef LCDSIM_T_HOME
+#define LCDSIM_T_HOME           1520000UL   // Clear display and return home
+#endif
+/** @} */
+
+struct LCD;
+
+/** Outputs of the simulated 74HC595, output n holds bit n of the value shifted by the library */
+extern volatile uint8_t LCDSim_sr595;
+
+/** Number of timing violations found since LCDSim_startCheck */
+extern uint16_t LCDSim_violations;
+
+/*!
+ @defined
+ @abstract   Size of the display data RAM of the model.
+ */
+#define LCDSIM_DDRAM_SIZE       0x80
+
+/** Display data RAM of the model by address, e.g. &LCDSim_ddram[LCD_rowAddress(lcd, 1)] is the second line */
+extern uint8_t LCDSim_ddram[LCDSIM_DDRAM_SIZE];
+
+/** Display, cursor and blink bits of the last display control instruction */
+extern uint8_t LCDSim_control;
+
+/*!
+\brief   Called by the library after every port write.
+\param      port The port written
+*/
+void LCDSim_portChanged(volatile uint8_t *port);
+
+/*!
+\brief   Connects an LCD signal to a port pin.
+\details Unconnected signals are low, like RW tied to ground.
+
+\param      signal LCDSIM_RS, LCDSIM_RW, LCDSIM_E or LCDSIM_D0 + n
+\param      port   The port, &LCDSim_sr595 for the shift register outputs, NULL to disconnect
+\param      bit    Pin of the port
+*/
+void LCDSim_connect(uint8_t signal, volatile uint8_t *port, uint8_t bit);
+
+/*!
+\brief   Feeds the simulated 74HC595 from port pins.
+\details Data is shifted on the rising edge of clock and copied to the
+outputs on the rising edge of latch.
+
+\param      port  The port
+\param      data  Serial data pin
+\param      clock Shift clock pin
+\param      latch Storage register clock pin
+*/
+void LCDSim_connect595(volatile uint8_t *port, uint8_t data, uint8_t clock, uint8_t latch);
+
+/*!
+\brief   Connects the pins the way an LCD initialized by LCD_initParallel is wired.
+\param      lcd The LCD object reference
+*/
+void LCDSim_wireParallel(struct LCD *lcd);
+
+/*!
+\brief   Connects the pins the way an LCD initialized by one of the LCD_initShiftReg is wired.
+\details For an LCD of a chain the registers are cascaded and the checker
+watches the register of that LCD.
+\param      lcd The LCD object reference
+*/
+void LCDSim_wireShiftReg(struct LCD *lcd);
+
+/*!
+\brief   Powers on the simulated HD44780 now and starts checking.
+\details Call it before LCD_begin, after wiring the pins.
+*/
+void LCDSim_startCheck(void);
+
+/*!
+\brief   Replaces the function receiving the violations.
+\details By default they are printed to stderr. Pass NULL to restore it.
+
+\param      report Function receiving the simulated time and a description
+*/
+void LCDSim_setReport(void (*report)(uint64_t time, const char *what));
+
+/*!
+\brief   Starts writing the LCD pins to a Value Change Dump file.
+\details Call it after wiring the pins, only the connected signals and the
+74HC595 inputs are dumped. Timestamps are in nanoseconds.
+
+\param      path File to write
+\return     false if the file can't be created
+*/
+bool LCDSim_vcdOpen(const char *path);
+
+/*!
+\brief   Sets the api marker of the dump, e.g. the name of the function called.
+\param      name Marker text, blanks are written as '_'
+*/
+void LCDSim_vcdMarker(const char *name);
+
+/*!
+\brief   Marks every byte sent to an LCD in the byte marker of the dump.
+\details Installs a send hook, call it once per LCD.
+\param      lcd The LCD object reference
+*/
+void LCDSim_vcdTrace(struct LCD *lcd);
+
+/*!
+\brief   Finishes the dump file.
+*/
+void LCDSim_vcdClose(void);
+
+#endif
@@ -0,0 +1,77 @@
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// Pseudo terminal standing in for the UART of a backpack in host builds.
+#define _XOPEN_SOURCE 600
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include "LCDSimPty.h"
+
+int LCDSim_openPty(char *name, size_t size)
+{
+    struct termios t;
+    const char *slave;
+    int fd;
+
+    fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (fd < 0)
+        return -1;
+
+    if (grantpt(fd) < 0 || unlockpt(fd) < 0 || (slave = ptsname(fd)) == NULL || strlen(slave) >= size) {
+        close(fd);
+        return -1;
+    }
+    strcpy(name, slave);
+
+    // Keep a slave open, otherwise reads fail while no client has it open
+    if (open(slave, O_RDWR | O_NOCTTY) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    // Raw 8 bit bytes, no echo and no line editing
+    if (tcgetattr(fd, &t) == 0) {
+        t.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON);
+        t.c_oflag &= ~OPOST;
+        t.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+        t.c_cflag = (t.c_cflag & ~(CSIZE | PARENB)) | CS8;
+        tcsetattr(fd, TCSANOW, &t);
+    }
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+int LCDSim_ptyReceive(int fd, struct LCDBackpack *bp, int timeoutMs)
+{
+    struct pollfd p;
+    uint8_t buf[64];
+    int room, n, i;
+
+    p.fd = fd;
+    p.events = POLLIN;
+    if (poll(&p, 1, timeoutMs) < 0)
+        return -1;
+
+    // One byte of the ring is always kept free
+    room = (bp->rxTail + bp->rxSize - bp->rxHead - 1) % bp->rxSize;
+    if (room > (int)sizeof(buf))
+        room = sizeof(buf);
+    if (room == 0)
+        return 0;
+
+    n = read(fd, buf, room);
+    if (n < 0)
+        return (errno == EAGAIN) ? 0 : -1;
+
+    for (i = 0; i < n; i++)
+        LCD_backpackReceive(bp, buf[i]);
+
+    return n;
+}
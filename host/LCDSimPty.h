@@ -0,0 +1,48 @@
+// ---------------------------------------------------------------------------
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// This software is furnished "as is", without technical support, and with no
+// warranty, express or implied, as to its usefulness for any purpose.
+//
+// Thread Safe: No
+//
+// @file LCDSimPty.h
+// Pseudo terminal standing in for the UART of a backpack in host builds.
+//
+// @brief
+// Runs the firmware side of LCDBackpack.h on Linux: the pty slave is the
+// serial port LCDproc or another Matrix Orbital client opens (e.g. Device=
+// /dev/pts/3 in the [MtxOrb] section of LCDd.conf), and the bytes it writes
+// go to the receive ring of the backpack as the UART interrupt would put them.
+// ---------------------------------------------------------------------------
+#ifndef _LCD_SIM_PTY_H_
+#define _LCD_SIM_PTY_H_
+
+#include <stddef.h>
+#include "LCDBackpack.h"
+
+/*!
+\brief   Opens a pseudo terminal in raw mode.
+\details The slave side is kept open, so the pty survives clients closing
+and reopening it.
+
+\param      name  Receives the path of the slave, for the client
+\param      size  Size of name
+\return     File descriptor of the master side, -1 on error
+*/
+int LCDSim_openPty(char *name, size_t size);
+
+/*!
+\brief   Moves the bytes written by the client to the receive ring of a backpack.
+\details Waits up to timeoutMs for the first byte, then takes what is
+available without waiting, as much as the ring has room for.
+
+\param      fd        The master side, from LCDSim_openPty
+\param      bp        The backpack
+\param      timeoutMs Longest wait, 0 not to wait, -1 to wait forever
+\return     Number of bytes received, -1 on error
+*/
+int LCDSim_ptyReceive(int fd, struct LCDBackpack *bp, int timeoutMs);
+
+#endif
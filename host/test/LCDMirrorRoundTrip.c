@@ -0,0 +1,112 @@
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// Round trip of LCDMirror.h through host/LCDMirrorDecoder.h: text, custom
+// glyphs, clears and keyframes are mirrored to a decoder fed from the start
+// and to one that joins at a keyframe, both must rebuild the same screen and
+// glyphs. Run with and without the CGRAM copy of the mirror.
+//
+// Build and run from the top directory:
+//
+//      cc -Ihost -Iinclude src/*.c host/*.c host/test/LCDMirrorRoundTrip.c -o mirror && ./mirror
+#include <stdio.h>
+#include <string.h>
+#include "LCDMirror.h"
+#include "LCDMirrorDecoder.h"
+
+#define COLS        16
+#define ROWS        2
+
+volatile uint8_t PORTC, PORTD;
+
+static struct LCDMirrorDecoder first;
+static struct LCDMirrorDecoder late;
+static bool joined;
+static int failed;
+
+static void sink(uint8_t value)
+{
+    LCDMirror_decode(&first, value);
+    if (joined)
+        LCDMirror_decode(&late, value);
+}
+
+static void checkText(const struct LCDMirrorDecoder *d, const char *name, uint8_t row, const char *text)
+{
+    uint8_t col;
+
+    for (col = 0; col < COLS; col++) {
+        if (LCDMirror_cell(d, col, row) != (uint8_t)(*text ? *text++ : ' ')) {
+            printf("%s: row %u differs at column %u\n", name, row, col);
+            failed = 1;
+            return;
+        }
+    }
+}
+
+static void checkGlyph(const struct LCDMirrorDecoder *d, const char *name, uint8_t location, const uint8_t *rows)
+{
+    if (memcmp(&d->cgram[location << 3], rows, 8) != 0) {
+        printf("%s: glyph %u differs\n", name, location);
+        failed = 1;
+    }
+}
+
+static void run(bool withCgram)
+{
+    static uint8_t heart[8] = { 0x00, 0x0A, 0x1F, 0x1F, 0x0E, 0x04, 0x00, 0x00 };
+    static uint8_t bell[8] = { 0x04, 0x0E, 0x0E, 0x0E, 0x1F, 0x00, 0x04, 0x00 };
+    uint8_t shadow[LCD_MIRROR_DDRAM_SIZE];
+    uint8_t cgram[64];
+    struct LCDMirror m;
+    struct LCD lcd;
+
+    printf("%s the CGRAM copy\n", withCgram ? "with" : "without");
+
+    LCDMirror_initDecoder(&first);
+    LCDMirror_initDecoder(&late);
+    joined = false;
+
+    LCD_initParallel(&lcd, LCD_4BITMODE, &PORTD, &PORTC, 0, 1);
+    LCD_begin(&lcd, COLS, ROWS, LCD_5x8DOTS);
+    LCD_initMirror(&m, &lcd, shadow, withCgram ? cgram : NULL, &sink, 0);
+
+    // A glyph still in the pending run when the screen is cleared
+    LCD_createChar(&lcd, 1, heart);
+    LCD_clear(&lcd);
+    LCD_printString(&lcd, "Hello");
+    LCD_setCursor(&lcd, 0, 1);
+    LCD_printString(&lcd, "World");
+    LCD_mirrorFlush(&m);
+
+    checkText(&first, "first", 0, "Hello");
+    checkText(&first, "first", 1, "World");
+    checkGlyph(&first, "first", 1, heart);
+
+    // A glyph still in the pending run when a keyframe is sent
+    LCD_createChar(&lcd, 2, bell);
+    joined = true;
+    LCD_mirrorKeyframe(&m, &lcd);
+    LCD_setCursor(&lcd, 6, 0);
+    LCD_printString(&lcd, "there");
+    LCD_mirrorFlush(&m);
+
+    checkText(&first, "first", 0, "Hello there");
+    checkGlyph(&first, "first", 2, bell);
+    checkText(&late, "late", 0, "Hello there");
+    checkText(&late, "late", 1, "World");
+    if (withCgram) {
+        // Only the keyframe brings the earlier glyphs to a late decoder
+        checkGlyph(&late, "late", 1, heart);
+        checkGlyph(&late, "late", 2, bell);
+    }
+}
+
+int main(void)
+{
+    run(true);
+    run(false);
+
+    printf("%s\n", failed ? "FAILED" : "passed");
+    return failed;
+}
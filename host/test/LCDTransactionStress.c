@@ -0,0 +1,186 @@
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// Stress test of LCDTransaction.h: several writer threads share one LCD on
+// the simulated bus, each one redraws its line in two halves and toggles its
+// own mode bit in a transaction. Whenever the lock is released no line may
+// show halves of different passes, and after every commit the mode bit of
+// the writer must still be as it set it. At the end the simulated screen must show
+// the last line of every writer, the display control register must hold the
+// last mode bits of every writer and the bus must have no timing violation.
+//
+// Build and run from the top directory:
+//
+//      cc -pthread -Ihost -Iinclude src/*.c host/*.c host/test/LCDTransactionStress.c -o stress && ./stress
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "LCDTransaction.h"
+
+#define WRITERS     4
+#define PASSES      2000
+#define COLS        20
+
+volatile uint8_t PORTC, PORTD;
+
+static struct LCD theLCD;
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static unsigned torn;
+static unsigned lost;
+static bool started;
+
+// The line of a writer, both halves show the pass
+static void line(char *text, unsigned writer, unsigned pass)
+{
+    snprintf(text, COLS + 1, "w%u p%05u w%u p%05u ", writer, pass % 100000, writer, pass % 100000);
+}
+
+// Count the lines whose halves differ, the lock must be held
+static void checkScreen(void)
+{
+    const uint8_t *p;
+    unsigned n;
+
+    for (n = 0; n < WRITERS; n++) {
+        p = &LCDSim_ddram[LCD_rowAddress(&theLCD, n)];
+        if (memcmp(p, p + COLS / 2, COLS / 2) != 0)
+            torn++;
+    }
+}
+
+static void lock(void *ctx)
+{
+    pthread_mutex_lock((pthread_mutex_t *)ctx);
+}
+
+static void unlock(void *ctx)
+{
+    if (started)
+        checkScreen();
+    pthread_mutex_unlock((pthread_mutex_t *)ctx);
+}
+
+static const struct LCDLock lcdLock = { &lock, &unlock, &mutex };
+
+// Only writer n changes its mode bit, it must still be set as it committed it
+static void checkBit(uint8_t bit, bool on)
+{
+    uint8_t want = on ? bit : 0;
+
+    pthread_mutex_lock(&mutex);
+    if ((theLCD.displaycontrol & bit) != want)
+        lost++;
+#ifndef LCD_LAZY_MODES
+    if ((LCDSim_control & bit) != want)
+        lost++;
+#endif
+    pthread_mutex_unlock(&mutex);
+}
+
+static void *writer(void *arg)
+{
+    unsigned n = (unsigned)(size_t)arg;
+    struct LCDTransaction tx;
+    uint8_t buf[64];
+    char text[COLS + 1];
+    unsigned pass;
+
+    for (pass = 0; pass < PASSES; pass++) {
+        // The last writer has a small buffer and holds the lock from the
+        // first overflow until the commit
+        LCD_beginTransaction(&tx, &theLCD, &lcdLock, buf, (n == WRITERS - 1) ? 8 : sizeof(buf));
+
+        line(text, n, pass);
+        LCD_setCursor(&tx.view, COLS / 2, n);
+        LCD_printString(&tx.view, text + COLS / 2);
+        sched_yield();
+        LCD_setCursor(&tx.view, 0, n);
+        text[COLS / 2] = '\0';
+        LCD_printString(&tx.view, text);
+
+        if (n == 0) {
+            if (pass & 1)
+                LCD_cursor(&tx.view);
+            else
+                LCD_noCursor(&tx.view);
+        } else if (n == 1) {
+            if (pass & 1)
+                LCD_blink(&tx.view);
+            else
+                LCD_noBlink(&tx.view);
+        }
+
+        LCD_commit(&tx);
+
+        if (n == 0)
+            checkBit(LCD_CURSORON, pass & 1);
+        else if (n == 1)
+            checkBit(LCD_BLINKON, pass & 1);
+        sched_yield();
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    pthread_t threads[WRITERS];
+    char text[COLS + 1];
+    uint8_t control;
+    unsigned n;
+    int failed = 0;
+
+    LCD_initParallel(&theLCD, LCD_4BITMODE, &PORTD, &PORTC, 0, 1);
+    LCDSim_wireParallel(&theLCD);
+    LCDSim_startCheck();
+    LCD_begin(&theLCD, COLS, WRITERS, LCD_5x8DOTS);
+
+    // Draw the first lines, from now on the screen is checked
+    for (n = 0; n < WRITERS; n++) {
+        line(text, n, 0);
+        LCD_setCursor(&theLCD, 0, n);
+        LCD_printString(&theLCD, text);
+    }
+    started = true;
+
+    for (n = 0; n < WRITERS; n++)
+        pthread_create(&threads[n], NULL, &writer, (void *)(size_t)n);
+    for (n = 0; n < WRITERS; n++)
+        pthread_join(threads[n], NULL);
+
+    LCD_flushModes(&theLCD);
+
+    for (n = 0; n < WRITERS; n++) {
+        line(text, n, PASSES - 1);
+        printf("|%.*s|\n", COLS, (const char *)&LCDSim_ddram[LCD_rowAddress(&theLCD, n)]);
+        if (memcmp(&LCDSim_ddram[LCD_rowAddress(&theLCD, n)], text, COLS) != 0) {
+            printf("line %u: expected \"%s\"\n", n, text);
+            failed = 1;
+        }
+    }
+
+    control = LCD_DISPLAYON | (((PASSES - 1) & 1) ? LCD_CURSORON | LCD_BLINKON : 0);
+    if (LCDSim_control != control || theLCD.displaycontrol != control) {
+        printf("display control: LCD %02X, object %02X, expected %02X\n", LCDSim_control, theLCD.displaycontrol, control);
+        failed = 1;
+    }
+
+    if (lost != 0) {
+        printf("%u mode changes lost\n", lost);
+        failed = 1;
+    }
+
+    if (torn != 0) {
+        printf("%u torn lines seen\n", torn);
+        failed = 1;
+    }
+
+    if (LCDSim_violations != 0) {
+        printf("%u timing violations\n", LCDSim_violations);
+        failed = 1;
+    }
+
+    printf("%s\n", failed ? "FAILED" : "passed");
+    return failed;
+}
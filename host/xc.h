@@ -0,0 +1,38 @@
+// ---------------------------------------------------------------------------
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// This software is furnished "as is", without technical support, and with no
+// warranty, express or implied, as to its usefulness for any purpose.
+//
+// @file xc.h
+// Host port shim for the PIC LCD library.
+//
+// @brief
+// Stands in for the XC8 device header when the library is compiled for the
+// host (put this directory first in the include path). The delay macros
+// advance a simulated clock instead of spinning, and the LCD timer reads that
+// clock, so the driver timing can be checked on a PC. Ports are plain
+// variables declared by the application, the data EEPROM is LCDSim_eeprom.
+// Port writes are reported to the simulated bus in LCDSimBus.h.
+// ---------------------------------------------------------------------------
+#ifndef _LCD_HOST_XC_H_
+#define _LCD_HOST_XC_H_
+
+#include "LCDSim.h"
+#include "LCDSimBus.h"
+
+#define __delay_us(x)   LCDSim_delay((uint32_t)(x) * 1000UL)
+#define __delay_ms(x)   LCDSim_delay((uint32_t)(x) * 1000000UL)
+
+#define LCD_portChanged(port)   LCDSim_portChanged(port)
+
+// Data EEPROM of the simulated device
+#define _EEPROMSIZE     LCDSIM_EEPROM_SIZE
+#define eeprom_read(addr)   LCDSim_eeprom[(addr) % LCDSIM_EEPROM_SIZE]
+
+#ifndef LCD_timerNow
+#define LCD_timerNow()  LCDSim_timerNow()
+#endif
+
+#endif
@@ -47,19 +47,147 @@ typedef uint8_t byte;
 // ---------------------------------------------------------------------------
 #define waitUsec(x)    __delay_us(x)
 
+// Called after every write to a port. It does nothing on the PIC, the host
+// shim uses it to watch the LCD pins.
+#ifndef LCD_portChanged
+#define LCD_portChanged(port)
+#endif
+
 #define setBit(port, bit_pos)           \
     do {                                \
         *(port) |= (1 << (bit_pos));    \
+        LCD_portChanged(port);          \
     } while (0)
 
 #define clearBit(port, bit_pos)         \
     do {                                \
         *(port) &= ~(1 << (bit_pos));   \
+        LCD_portChanged(port);          \
+    } while (0)
+
+#define setMask(port, mask)             \
+    do {                                \
+        *(port) |= (mask);              \
+        LCD_portChanged(port);          \
+    } while (0)
+
+#define clearMask(port, mask)           \
+    do {                                \
+        *(port) &= ~(mask);             \
+        LCD_portChanged(port);          \
     } while (0)
 
+/*!
+ \brief   Scheduling of the LCD execution times.
+ \details By default the drivers wait for the LCD to execute every command
+ right after sending it. When LCD_USE_TIMER is defined the drivers only
+ record when the LCD will be ready, and wait for whatever part of that time
+ is still pending before the next transfer. Time spent by the application
+ between LCD calls is then not wasted.
+
+ LCD_timerNow() must return a free running 16 bit counter incrementing every
+ microsecond. It defaults to TMR1, which has to be configured and started by
+ the application (e.g. Fosc/4 with 1:2 prescaler at 8MHz). Define it before
+ including this file, or in the compiler options, to use another timer. A
+ 16 bit timer read as two bytes must not be torn by a carry between them,
+ see LCD_readTMR1.
+ */
+#ifdef LCD_USE_TIMER
+#ifndef LCD_timerNow
+#define LCD_timerNow()  LCD_readTMR1()
+#define LCD_TIMER_TMR1
+
+/*!
+\brief   Reads TMR1 without tearing.
+\details PIC16 parts have no read buffer for TMR1H, so a carry from TMR1L
+between the two byte reads would be off by 256 us. TMR1H is read again and
+the read is retried when it changed.
+*/
+uint16_t LCD_readTMR1(void);
+#endif
+#define LCD_setBusy(this, usec)                                 \
+    do {                                                        \
+        (this)->readyAt = LCD_timerNow() + (usec);              \
+    } while (0)
+#else
+#define LCD_waitReady(this)
+#define LCD_setBusy(this, usec)     waitUsec(usec)
+#endif
+
+/*!
+ \brief   Execution times learned from the busy flag.
+ \details By default the drivers give every command EXEC_TIME and clear and
+ home HOME_CLEAR_EXEC, the worst case of the datasheet. Most modules are
+ faster, and lots from different vendors vary a lot. When LCD_CALIBRATE is
+ defined, begin measures the execution time of data writes, address sets,
+ clear/home and CGRAM writes on the attached module by polling the busy flag
+ with LCD_timerNow(), and keeps them with a margin as the timing profile of
+ the LCD. The sends then run open loop at the learned speed.
+
+ Calibrating needs LCD_USE_TIMER and an LCD with an RW pin (see
+ LCD_initParallelRW), the others keep the worst case times.
+ */
+#ifdef LCD_CALIBRATE
+#ifndef LCD_USE_TIMER
+#error "LCD_CALIBRATE needs LCD_USE_TIMER"
+#endif
+#define LCD_execBusy(this, value, mode) LCD_setBusy(this, LCD_execTime(this, value, mode))
+#define LCD_homeClearTime(this)         ((this)->timing.homeClear)
+#else
+#define LCD_execBusy(this, value, mode) LCD_setBusy(this, EXEC_TIME)
+#define LCD_homeClearTime(this)         HOME_CLEAR_EXEC
+#endif
+
+/*!
+ @defined
+ @abstract   Margin added to the measured execution times, in percent.
+ */
+#ifndef LCD_CAL_MARGIN
+#define LCD_CAL_MARGIN      25
+#endif
+
+/*!
+ @defined
+ @abstract   Measures taken of every command class, the slowest one is kept.
+ */
+#ifndef LCD_CAL_SAMPLES
+#define LCD_CAL_SAMPLES     4
+#endif
+
+/*!
+ @defined
+ @abstract   Shortest believable execution time in microseconds.
+ @discussion A busy flag that clears faster than this is not trusted (e.g.
+ the RW pin or D7 is not wired, or the module hardly reports busy), the LCD
+ keeps the worst case times.
+ */
+#ifndef LCD_CAL_MIN
+#define LCD_CAL_MIN         10
+#endif
+
+/*!
+ \brief   Deferred mode registers.
+ \details By default LCD_display, LCD_cursor, LCD_blink, LCD_leftToRight,
+ LCD_autoscroll and the like send the display control or entry mode command
+ right away. When LCD_LAZY_MODES is defined they only change the value in
+ RAM, and the registers that differ from what the controller has are sent
+ before the next character is written or by LCD_flushModes. Toggling the
+ cursor around an edit then costs nothing unless its final state changes.
+ */
 #define LCD_send(this, value, mode) (this)->send((this), (value), (mode))
 #define LCD_command(this, value)    LCD_send(this, value, COMMAND)
+#ifdef LCD_LAZY_MODES
+#define LCD_write(this, value)      LCD_writeData(this, value)
+#define LCD_flushModes(this)                                            \
+    do {                                                                \
+        if ((this)->displaycontrol != (this)->sentcontrol ||            \
+            (this)->displaymode != (this)->sentmode)                    \
+            LCD_syncModes(this);                                        \
+    } while (0)
+#else
 #define LCD_write(this, value)      LCD_send(this, value, DATA)
+#define LCD_flushModes(this)
+#endif
 
 /*!
  @defined 
@@ -69,6 +197,14 @@ typedef uint8_t byte;
  */
 #define EXEC_TIME 40
 
+/*!
+ @defined 
+ @abstract   Extra wait after each CGRAM access.
+ @discussion Kept from the original library on top of EXEC_TIME, the
+ calibrated times already cover it. The time is expressed in micro-seconds.
+ */
+#define CGRAM_EXTRA 40
+
 /*!
  \brief   LCD available commands. All these definitions shouldn't be used unless you are writing
  a driver.
@@ -194,6 +330,48 @@ typedef uint8_t byte;
 
 /** @} */
 
+/*!
+ \brief   Shift register wirings. All these definitions shouldn't be used unless you are writing
+ a driver.
+ \details LCD_SR_ENABLE_BIT is the classic 3 wire wiring, the LCD enable is
+ driven by a shift register output so every nibble takes two shifts.
+ LCD_SR_ENABLE_STROBE has the LCD enable wired to the strobe line, the LCD
+ latches the nibble when the strobe falls so every nibble takes one shift.
+ LCD_SR_8BIT has the 8 data lines on the shift register outputs, the enable
+ on the strobe line and RS on a pin of the same port, one shift per byte.
+ LCD_SR_CHAIN is the LCD_SR_ENABLE_BIT wiring with several shift registers
+ cascaded on the same three pins, one per LCD (see struct LCDChain).
+ */
+
+/**
+ * \defgroup LCD_ShiftRegModes Shift register wirings
+ *
+ * @{
+ */
+
+#define LCD_SR_ENABLE_BIT       0
+#define LCD_SR_ENABLE_STROBE    1
+#define LCD_SR_8BIT             2
+#define LCD_SR_CHAIN            3
+
+/** @} */
+
+/*!
+ @defined
+ @abstract   Maximum number of LCDs on a shift register chain.
+ */
+#ifndef LCD_CHAIN_MAX
+#define LCD_CHAIN_MAX           4
+#endif
+
+/*!
+ @defined
+ @abstract   Bytes queued per LCD of a chain, a power of 2 up to 8.
+ */
+#ifndef LCD_CHAIN_QUEUE
+#define LCD_CHAIN_QUEUE         8
+#endif
+
 /*!
  \def   HOME_CLEAR_EXEC
  \brief   Defines the duration of the home and clear commands
@@ -202,14 +380,77 @@ typedef uint8_t byte;
  */
 #define HOME_CLEAR_EXEC      2000
 
+/*!
+ \def   LCD_RESYNC_TIME
+ \brief   Defines the duration of LCD_resync
+ \details The waits of the datasheet init sequence, 4.5ms + 4.5ms + 150us,
+ then the 4 bit mode nibble and the function set - Time in microseconds,
+ without the bus time of the transfers.
+ */
+#define LCD_RESYNC_TIME      (4500 + 4500 + 150 + 2 * EXEC_TIME)
+
+/*!
+ \def   LCD_SR_SHIFT_TIME
+ \brief   Time it takes to shift a byte out to the shift register
+ \details Used to estimate the cost of the shift register operations, it
+ depends on the instruction clock. The default is for 2 MIPS (8MHz oscillator),
+ time in microseconds.
+ */
+#ifndef LCD_SR_SHIFT_TIME
+#define LCD_SR_SHIFT_TIME    30
+#endif
+
+/*!
+ \brief   Operations whose cost can be estimated with LCD_estimateCostUs
+ */
+
+/**
+ * \defgroup LCD_CostOps Operations for cost estimation
+ *
+ * @{
+ */
+
+#define LCD_OP_WRITE            0   // LCD_printString / LCD_write of len chars
+#define LCD_OP_COMMAND          1   // Any command but clear and home
+#define LCD_OP_SETCURSOR        2
+#define LCD_OP_CLEAR            3
+#define LCD_OP_HOME             4
+#define LCD_OP_CREATECHAR       5
+#define LCD_OP_PRINTUINT        6   // Worst case, 5 digits
+#define LCD_OP_PRINTSINT        7   // Worst case, sign and 5 digits
+
+/** @} */
+
+/*!
+ \brief   Time costs of a driver and timing profile, in microseconds
+ */
+struct LCDCosts {
+    uint16_t xfer;          // Bus time to send a byte, without execution time
+    uint16_t exec;          // Execution time of a command or data write
+    uint16_t homeClear;     // Execution time of clear and home
+};
+
+/*!
+ \brief   Execution times of an LCD module, in microseconds
+ */
+struct LCDTiming {
+    uint16_t write;         // Data write to DDRAM
+    uint16_t address;       // Set address and the other commands
+    uint16_t homeClear;     // Clear and home
+    uint16_t cgram;         // Data write to CGRAM
+};
+
 /*!
  \brief   This struct represents a parallel interface for the LCD
  */
 struct LCDParallelInt {
     volatile uint8_t *lcd_dport;    // Data port
     volatile uint8_t *lcd_cport;    // Control port
+    volatile uint8_t *lcd_dtris;    // Data port direction, only with RW pin
+    volatile uint8_t *lcd_dread;    // Data port input register, only with RW pin
     uint8_t rs_pin;
     uint8_t enable_pin;
+    uint8_t rw_pin;
 };
 
 /*!
@@ -220,6 +461,68 @@ struct LCDShiftRegInt {
     uint8_t srdata_pin;  // Serial Data pin
     uint8_t srclock_pin; // Clock Pin
     uint8_t strobe_pin;  // Enable Pin
+    uint8_t rs_pin;      // Register Select pin, only used by LCD_SR_8BIT
+    uint8_t mode;        // LCD_SR_ENABLE_BIT, LCD_SR_ENABLE_STROBE, LCD_SR_8BIT or LCD_SR_CHAIN
+    uint8_t out;         // Last value latched into the register
+    struct LCDChain *chain; // Only used by LCD_SR_CHAIN
+    uint8_t index;       // Position in the chain, 0 is the register next to the PIC
+};
+
+/*!
+ \brief   Shift registers cascaded on three pins, one per LCD
+ \details Each LCD is wired as with LCD_initShiftReg to its own 74HC595,
+ the serial output of a register feeds the data input of the next one and
+ all of them share the clock and strobe lines. One shift burst sets the
+ outputs of every register, so a nibble for every LCD goes out at once with
+ only the enable bits of the LCDs being written raised.
+
+ Bytes sent to the LCDs of a chain are queued, LCD_chainFlush packs them into
+ bursts: each round carries the next byte of every LCD that has one and is
+ ready, so the LCDs are refreshed in parallel and execute their commands at
+ the same time. A full queue is flushed by the next send.
+ */
+struct LCDChain {
+    volatile uint8_t *port;
+    uint8_t data;       // Serial data pin
+    uint8_t clock;      // Shift clock pin
+    uint8_t strobe;     // Storage register clock pin
+    uint8_t count;      // Number of LCDs
+
+    /** Outputs of each register, without the enable bit */
+    uint8_t out[LCD_CHAIN_MAX];
+
+    /** Bytes waiting for each LCD, bit n of mode is set if entry n is data */
+    uint8_t queue[LCD_CHAIN_MAX][LCD_CHAIN_QUEUE];
+    uint8_t mode[LCD_CHAIN_MAX];
+    uint8_t head[LCD_CHAIN_MAX];
+    uint8_t len[LCD_CHAIN_MAX];
+
+    /** Bit n is set while the data sent to LCD n goes to CGRAM */
+    uint8_t cgram;
+
+#ifdef LCD_USE_TIMER
+    /** Timer value when each LCD will be done with its last byte */
+    uint16_t readyAt[LCD_CHAIN_MAX];
+#endif
+};
+
+struct LCD;
+
+/*!
+ \brief   Hook on the send method of an LCD.
+ \details Hooks let modules see (and alter) every byte sent to the LCD. The
+ send function of the hook must pass the byte on with LCD_hookForward. To
+ keep module data with the hook, make the hook the first member of the
+ module struct.
+ */
+struct LCDHook {
+    void (*send)(struct LCDHook *hook, struct LCD *lcd, uint8_t value, uint8_t mode);
+
+    /** Next hook towards the driver, NULL for the last one */
+    struct LCDHook *below;
+
+    /** Send method of the driver, used by the last hook */
+    void (*driverSend)(struct LCD *this, uint8_t value, uint8_t mode);
 };
 
 /*!
@@ -242,21 +545,55 @@ struct LCD
     /** Text entry mode to the LCD */
     uint8_t displaymode;
 
+#ifdef LCD_LAZY_MODES
+    /** Display control and entry mode the controller has */
+    uint8_t sentcontrol;
+    uint8_t sentmode;
+#endif
+
     /** Number of lines of the LCD, initialized with begin() */
     uint8_t numlines;
 
     /** Number of columns in the LCD */
     uint8_t cols;
 
+    /** Time costs of the driver, set by the init function */
+    const struct LCDCosts *costs;
+
     /** Data related to specific driver implementation */
     union {
         struct LCDParallelInt pi;
         struct LCDShiftRegInt sri;
     } i;
 
+#ifdef LCD_USE_TIMER
+    /** Timer value when the LCD will be done with the last command */
+    uint16_t readyAt;
+#endif
+
+#ifdef LCD_CALIBRATE
+    /** Timing profile, learned by begin */
+    struct LCDTiming timing;
+
+    /** The address counter points to CGRAM */
+    bool cgram;
+#endif
+
+    /** Last hook installed with LCD_addHook, NULL if none */
+    struct LCDHook *hook;
+
+    /** The bytes sent are queued or recorded, see LCD_isQueued */
+    bool queued;
+
     /** Methods related to the I/O interface of the driver */
     void (*send)(struct LCD *this, uint8_t value, uint8_t mode);
     void (*begin)(struct LCD *this, uint8_t cols, uint8_t lines, uint8_t dotsize);
+
+    /** Puts a running LCD back in the interface mode (4/8 bits) and nibble sync */
+    void (*resync)(struct LCD *this);
+
+    /** Reads the busy flag/address (COMMAND) or data (DATA), NULL without RW pin */
+    uint8_t (*read)(struct LCD *this, uint8_t mode);
 };
 
 /**
@@ -282,6 +619,103 @@ implementation should be done on the driver specif class.
 */
 #define LCD_begin(this, cols, rows, charsize)   (this)->begin((this), cols, rows, charsize)
 
+#ifdef LCD_USE_TIMER
+/*!
+\brief   Waits until the LCD is done with the last command.
+\details Busy waits on LCD_timerNow() for the pending part of the execution
+time of the last command. Drivers call it before every transfer, it returns
+immediately when the time has already passed. Only available with
+LCD_USE_TIMER, otherwise the drivers wait right after each transfer.
+
+\param this The LCD object reference
+*/
+void LCD_waitReady(struct LCD *this);
+#endif
+
+#ifdef LCD_CALIBRATE
+/*!
+\brief   Sets the worst case timing profile.
+\details Called by the init functions.
+
+\param this The LCD object reference
+*/
+void LCD_defaultTiming(struct LCD *this);
+
+/*!
+\brief   Learns the timing profile of the module from the busy flag.
+\details Called by begin on LCDs with an RW pin. It clears the display,
+the contents of CGRAM are kept. Send hooks installed before see the bytes
+sent, the time they spend after forwarding a byte is missed by the measure.
+If the busy flag can't be trusted the profile is left as it was.
+
+\param this The LCD object reference
+*/
+void LCD_calibrate(struct LCD *this);
+
+/*!
+\brief   Execution time of a byte sent to the LCD.
+\details Used by the drivers through LCD_execBusy.
+
+\param this  The LCD object reference
+\param value The byte sent
+\param mode  COMMAND or DATA
+\return      The time from the timing profile
+*/
+uint16_t LCD_execTime(struct LCD *this, uint8_t value, uint8_t mode);
+#endif
+
+/*!
+\brief   Resynchronizes the LCD interface.
+\details Puts the LCD back in the interface mode set by begin, even when it
+has lost the nibble sync in 4 bit mode, and sends the function set again.
+DDRAM contents, display control and entry mode are not restored.
+
+\hideinitializer
+\param      this The LCD object reference
+*/
+#define LCD_resync(this)    (this)->resync(this)
+
+/*!
+\brief   Installs a hook on the send method of the LCD.
+\details The hook sees every byte sent after this call, before the hooks
+installed earlier. Hooks must be installed after the init function of the
+driver.
+
+\param      this The LCD object reference
+\param      hook The hook
+\param      send Function called for every byte sent
+*/
+void LCD_addHook(struct LCD *this, struct LCDHook *hook, void (*send)(struct LCDHook *hook, struct LCD *lcd, uint8_t value, uint8_t mode));
+
+/*!
+\brief   Passes a byte to the next hook or to the driver.
+
+\param      hook  The hook passing the byte
+\param      lcd   The LCD object reference
+\param      value Byte to send
+\param      mode  COMMAND or DATA
+*/
+void LCD_hookForward(struct LCDHook *hook, struct LCD *lcd, uint8_t value, uint8_t mode);
+
+#ifdef LCD_LAZY_MODES
+/*!
+\brief   Sends the mode registers that changed, then writes a character.
+\details This is LCD_write when LCD_LAZY_MODES is defined.
+
+\param      this  The LCD object reference
+\param      value Character to write
+*/
+void LCD_writeData(struct LCD *this, uint8_t value);
+
+/*!
+\brief   Sends the display control and entry mode if they differ from the controller.
+\details Use LCD_flushModes, which only calls this when something changed.
+
+\param      this  The LCD object reference
+*/
+void LCD_syncModes(struct LCD *this);
+#endif
+
 /*!
 \brief   Clears the LCD.
 \details Clears the LCD screen and positions the cursor in the upper-left
@@ -462,6 +896,16 @@ subsequent text written to the LCD will be displayed.
 */
 void LCD_setCursor(struct LCD *this, uint8_t col, uint8_t row);
 
+/*!
+\brief   DDRAM address of the first column of a row.
+\details Takes into account the memory map of the LCD size.
+
+\param      this The LCD object reference
+\param      row  LCD row - line.
+\return     DDRAM address
+*/
+uint8_t LCD_rowAddress(struct LCD *this, uint8_t row);
+
 /*!
 \brief   Switch on the LCD module.
 \details Switch on the LCD module, it will switch on the LCD controller
@@ -514,6 +958,20 @@ position.
 */
 void LCD_printSInt(struct LCD *this, int16_t value);
 
+/*!
+\brief   Estimates the worst case time of an operation.
+\details Gives the time in microseconds an operation takes on this LCD, taking
+into account the interface used by the driver. With LCD_USE_TIMER part of it
+overlaps with whatever the application does after the call, so it's an
+upper bound.
+
+\param      this The LCD object reference
+\param      op   Operation, one of the LCD_OP_* values
+\param      len  Number of characters for LCD_OP_WRITE, ignored otherwise
+\return     Time in microseconds, 0xFFFF if it is longer
+*/
+uint16_t LCD_estimateCostUs(struct LCD *this, uint8_t op, uint8_t len);
+
 /*!
 \brief   Writes a character to the LCD.
 \details This function writes a character to the LCD in the current cursor
@@ -523,7 +981,7 @@ position.
 \param      this The LCD object reference
 \param      value Value to write to the LCD.
 */
-#define LCD_printChar(this, value) (this)->send(this, value, DATA)
+#define LCD_printChar(this, value) LCD_write(this, value)
 
 /*!
 \brief   Initialize the LCD in parallel mode.
@@ -538,6 +996,32 @@ position.
 */
 void LCD_initParallel(struct LCD *this, uint8_t bitmode, volatile uint8_t *lcd_dport, volatile uint8_t *lcd_cport, uint8_t rs_pin, uint8_t enable_pin);
 
+/*!
+\brief   Initialize the LCD in parallel mode with the RW pin connected.
+\details Same as LCD_initParallel, with RW connected the LCD can be read
+back (see LCD.read). The data lines are switched to inputs through the
+direction register only while reading.
+
+\param      this        The LCD object reference
+\param      bitmode     4/8 access mode.
+\param      lcd_dport   Data port (output latch)
+\param      lcd_cport   Control port
+\param      rs_pin      Register Select pin to use in control port
+\param      enable_pin  Enable (Clock) pin to use in control port
+\param      rw_pin      Read/Write pin to use in control port
+\param      lcd_dtris   Data port direction register
+\param      lcd_dread   Data port input register
+*/
+void LCD_initParallelRW(struct LCD *this, uint8_t bitmode, volatile uint8_t *lcd_dport, volatile uint8_t *lcd_cport, uint8_t rs_pin, uint8_t enable_pin,
+                        uint8_t rw_pin, volatile uint8_t *lcd_dtris, volatile uint8_t *lcd_dread);
+
+/*!
+\brief   Begin method of the parallel driver.
+\details Called through LCD_begin, a module can compare the begin method of
+an LCD with it to know that the LCD uses the parallel driver.
+*/
+void LCD_beginParallel(struct LCD *this, uint8_t cols, uint8_t lines, uint8_t dotsize);
+
 /*!
 \brief   Initialize the LCD in parallel mode.
 \details Initialize the LCD to use the parallel interface.
@@ -549,6 +1033,81 @@ void LCD_initParallel(struct LCD *this, uint8_t bitmode, volatile uint8_t *lcd_d
 \param      strobe      Shift register strobe pin
 */
 void LCD_initShiftReg(struct LCD *this, volatile uint8_t *sr_port, uint8_t srdata, uint8_t srclock, uint8_t strobe);
+
+/*!
+\brief   Initialize the LCD in shift register mode with the enable on the strobe line.
+\details Same wiring as LCD_initShiftReg, but the LCD enable pin is connected to
+the strobe pin of the shift register instead of to a shift register output.
+Each nibble is sent with a single shift and strobe. RS changes with the
+latch that raises E, so it has no setup time before E; most modules
+tolerate it, LCD_initShiftReg does not have that limit.
+
+\param      this        The LCD object reference
+\param      sr_port     Port where the shift register is connected
+\param      srdata      Shift register data pin
+\param      srclock     Shift register clock pin
+\param      strobe      Shift register strobe pin, also LCD enable
+*/
+void LCD_initShiftRegStrobe(struct LCD *this, volatile uint8_t *sr_port, uint8_t srdata, uint8_t srclock, uint8_t strobe);
+
+/*!
+\brief   Initialize the LCD in 8 bit shift register mode.
+\details The shift register outputs drive the 8 data lines of the LCD, the
+LCD enable pin is connected to the strobe pin and RS to another pin of the
+same port. Each byte is sent with a single shift and strobe.
+
+\param      this        The LCD object reference
+\param      sr_port     Port where the shift register is connected
+\param      srdata      Shift register data pin
+\param      srclock     Shift register clock pin
+\param      strobe      Shift register strobe pin, also LCD enable
+\param      rs          LCD Register Select pin
+*/
+void LCD_initShiftReg8(struct LCD *this, volatile uint8_t *sr_port, uint8_t srdata, uint8_t srclock, uint8_t strobe, uint8_t rs);
+
+/*!
+\brief   Initialize a chain of shift registers, one per LCD.
+\details The enable outputs of all the registers are pulled low. Then
+initialize each LCD with LCD_initShiftRegChain.
+
+\param      chain       The chain
+\param      sr_port     Port where the first shift register is connected
+\param      srdata      Shift register data pin
+\param      srclock     Shift register clock pin, shared by all the registers
+\param      strobe      Shift register strobe pin, shared by all the registers
+\param      count       Number of registers, up to LCD_CHAIN_MAX
+*/
+void LCD_initChain(struct LCDChain *chain, volatile uint8_t *sr_port, uint8_t srdata, uint8_t srclock, uint8_t strobe, uint8_t count);
+
+/*!
+\brief   Initialize an LCD on a chain of shift registers.
+\details The bytes sent to the LCD are queued until LCD_chainFlush. LCD_begin
+sends the init sequence of this LCD right away.
+
+\param      this        The LCD object reference
+\param      chain       The chain, initialized with LCD_initChain
+\param      index       Position of its register, 0 is the one next to the PIC
+\return     false if index is not below the count of the chain, the LCD is
+            then left untouched
+*/
+bool LCD_initShiftRegChain(struct LCD *this, struct LCDChain *chain, uint8_t index);
+
+/*!
+\brief   Tells whether the bytes sent to an LCD are queued.
+\details The chain driver waits for each command when it sends it and a
+transaction view only records the bytes, so the waits after clear, home and
+CGRAM writes are left to whoever sends them: waiting when the command is
+queued would only hold back the other LCDs of the chain or the task.
+*/
+#define LCD_isQueued(this)  ((this)->queued)
+
+/*!
+\brief   Sends the bytes queued for the LCDs of a chain.
+\details Call it after drawing on the LCDs, e.g. once per refresh.
+
+\param      chain       The chain
+*/
+void LCD_chainFlush(struct LCDChain *chain);
 #endif
 
 /** @} */
\ No newline at end of file
@@ -0,0 +1,180 @@
+// ---------------------------------------------------------------------------
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// This software is furnished "as is", without technical support, and with no
+// warranty, express or implied, as to its usefulness for any purpose.
+//
+// Thread Safe: No, except LCD_backpackReceive
+// Extendable: Yes
+//
+// @file LCDBackpack.h
+// Serial display backpack speaking the Matrix Orbital command set.
+//
+// @brief
+// Turns the PIC into a serial LCD backpack that LCDproc (MtxOrb driver) and
+// other Matrix Orbital clients can drive. The UART interrupt puts the bytes
+// received in a ring buffer with LCD_backpackReceive, the main loop calls
+// LCD_backpackPoll, which applies every command received so far to a RAM copy
+// of the screen and then sends the LCD only what changed: a frame redrawn by
+// the host costs the cells that differ, cursor moves cost nothing until text
+// is written, a clear followed by the new text is sent as a clear only when
+// that is faster, and custom characters redefined many times are uploaded
+// once.
+//
+// Text bytes are shown as is, 0 to 7 are the custom characters. \r, \n and
+// \b move the cursor. Commands start with 0xFE:
+//
+//      'X'             Clear screen, cursor home
+//      'H'             Cursor home
+//      'G' col row     Cursor position, 1 based
+//      'L' / 'M'       Cursor left / right
+//      'J' / 'K'       Underline cursor on / off
+//      'S' / 'T'       Blinking block cursor on / off
+//      'C' / 'D'       Auto line wrap on / off
+//      'Q' / 'R'       Auto scroll on / off
+//      'N' n b0..b7    Define custom character n
+//      'B' min / 'F'   Backlight on / off
+//
+// Contrast, brightness and GPO commands are accepted and ignored, other
+// commands are ignored.
+// ---------------------------------------------------------------------------
+#ifndef _LCD_BACKPACK_H_
+#define _LCD_BACKPACK_H_
+
+#include "LCD.h"
+
+/*!
+ @defined
+ @abstract   Maximum number of lines of the LCD of a backpack.
+ */
+#define LCD_BACKPACK_MAXROWS    4
+
+/*!
+ @defined
+ @abstract   Command prefix of the Matrix Orbital protocol.
+ */
+#define LCD_BACKPACK_PREFIX     0xFE
+
+/*!
+ \brief   State of a backpack
+ */
+struct LCDBackpack {
+    struct LCD *lcd;
+
+    /** Receive ring buffer, written by the UART interrupt */
+    uint8_t *rx;
+    uint8_t rxSize;
+    volatile uint8_t rxHead;
+    volatile uint8_t rxTail;
+
+    /** Screen requested by the host, numlines * cols chars */
+    uint8_t *screen;
+
+    /** Columns not yet sent to the LCD on each line, dmin > dmax if none */
+    uint8_t dmin[LCD_BACKPACK_MAXROWS];
+    uint8_t dmax[LCD_BACKPACK_MAXROWS];
+
+    /** Cursor position, col == cols means the line is full */
+    uint8_t col;
+    uint8_t row;
+
+    /** Position where the LCD will write next, 0xFF if unknown */
+    uint8_t lcdCol;
+    uint8_t lcdRow;
+
+    /** The screen was cleared since the last flush */
+    bool cleared;
+
+    bool wrap;
+    bool scroll;
+
+    /** LCD_CURSORON and LCD_BLINKON as requested by the host */
+    uint8_t cursor;
+
+    /** Backlight requested by the host */
+    bool light;
+
+    /** Custom characters, the ones defined and the ones not yet uploaded (bit n for glyph n) */
+    uint8_t glyphs[8][8];
+    uint8_t glyphValid;
+    uint8_t glyphDirty;
+
+    /** Command parser: command byte, arguments expected and received */
+    uint8_t cmd;
+    uint8_t nargs;
+    uint8_t got;
+    uint8_t args[9];
+
+    /** Switches the backlight, NULL to turn the display on and off instead */
+    void (*backlight)(bool on);
+};
+
+/**
+ * \defgroup LCD_BackpackFunctions LCD Backpack Functions
+ *
+ * @{
+ */
+
+/*!
+\brief   Puts a received byte in the ring buffer of a backpack.
+\details A macro so it can be used from the UART interrupt without a call.
+When the ring is full the byte is dropped.
+
+\param      bp    The backpack
+\param      byte  Byte received
+*/
+#define LCD_backpackReceive(bp, byte)                           \
+    do {                                                        \
+        uint8_t next_ = (bp)->rxHead + 1;                       \
+        if (next_ == (bp)->rxSize)                              \
+            next_ = 0;                                          \
+        if (next_ != (bp)->rxTail) {                            \
+            (bp)->rx[(bp)->rxHead] = (byte);                    \
+            (bp)->rxHead = next_;                               \
+        }                                                       \
+    } while (0)
+
+/*!
+\brief   Initializes a backpack and clears the LCD.
+\details The backpack owns the LCD from now on.
+
+\param      bp        The backpack
+\param      lcd       The LCD, already initialized with LCD_begin
+\param      screen    Buffer of lcd->numlines * lcd->cols chars
+\param      rx        Receive ring buffer, e.g. 64 bytes at 19200 baud
+\param      rxSize    Size of the ring buffer, it holds rxSize - 1 bytes
+\param      backlight Switches the backlight, NULL if there is no backlight control
+*/
+void LCD_initBackpack(struct LCDBackpack *bp, struct LCD *lcd, uint8_t *screen, uint8_t *rx, uint8_t rxSize,
+                      void (*backlight)(bool on));
+
+/*!
+\brief   Applies the bytes received and updates the LCD.
+\details Call it from the main loop. All the bytes waiting in the ring are
+parsed first, then the changes are sent in one pass.
+
+\param      bp    The backpack
+*/
+void LCD_backpackPoll(struct LCDBackpack *bp);
+
+/*!
+\brief   Parses one byte of the protocol.
+\details The LCD is not updated until the next LCD_backpackPoll, or
+LCD_backpackFlush. Useful to feed the backpack from other sources.
+
+\param      bp    The backpack
+\param      byte  Byte of the protocol
+*/
+void LCD_backpackPut(struct LCDBackpack *bp, uint8_t byte);
+
+/*!
+\brief   Sends the pending changes to the LCD.
+
+\param      bp    The backpack
+*/
+void LCD_backpackFlush(struct LCDBackpack *bp);
+
+/** @} */
+
+#endif
@@ -0,0 +1,128 @@
+// ---------------------------------------------------------------------------
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// This software is furnished "as is", without technical support, and with no
+// warranty, express or implied, as to its usefulness for any purpose.
+//
+// Thread Safe: No
+// Extendable: Yes
+//
+// @file LCDCanvas.h
+// Small pixel canvas made of the CGRAM glyphs.
+//
+// @brief
+// The 8 custom glyphs are used as the tiles of a bitmap, e.g. 4x2 cells of
+// 5x8 pixels give a 20x16 pixel canvas. The DDRAM cells showing the tiles
+// are written once, drawing only changes a RAM copy of the bitmap and
+// LCD_canvasFlush uploads the glyph rows that changed, with one CGRAM
+// address per glyph and none of the extra delays of LCD_createChar.
+// ---------------------------------------------------------------------------
+#ifndef _LCD_CANVAS_H_
+#define _LCD_CANVAS_H_
+
+#include "LCD.h"
+
+/*!
+ \brief   State of a canvas
+ */
+struct LCDCanvas {
+    /** Pixel rows of every tile, bit 4 is the leftmost pixel */
+    uint8_t bits[64];
+
+    /** Rows changed since the last flush, a bit per row for every tile */
+    uint8_t dirty[8];
+
+    /** Position and size on the LCD in cells, first glyph used */
+    uint8_t col;
+    uint8_t row;
+    uint8_t cols;
+    uint8_t rows;
+    uint8_t first;
+};
+
+/**
+ * \defgroup LCD_CanvasFunctions LCD Canvas Functions
+ *
+ * @{
+ */
+
+/*!
+\brief   Initializes a canvas and shows it.
+\details Writes the DDRAM cells showing the tiles and uploads a blank
+bitmap. The canvas uses the glyphs first to first + cols * rows - 1, at
+most 8 glyphs in total. A canvas that does not fit is cut down: cols to
+8 - first, then rows to the glyphs left.
+
+\param      this  The LCD object reference
+\param      c     The canvas
+\param      col   Column of the top left cell
+\param      row   Row of the top left cell
+\param      cols  Width in cells
+\param      rows  Height in cells
+\param      first First glyph used
+*/
+void LCD_initCanvas(struct LCD *this, struct LCDCanvas *c, uint8_t col, uint8_t row, uint8_t cols, uint8_t rows, uint8_t first);
+
+/*!
+\brief   Clears all the pixels.
+\param      c     The canvas
+*/
+void LCD_canvasClear(struct LCDCanvas *c);
+
+/*!
+\brief   Sets or clears a pixel.
+\details Pixels outside the canvas are ignored.
+
+\param      c     The canvas
+\param      x     Column, 0 to cols * 5 - 1
+\param      y     Row, 0 to rows * 8 - 1, 0 at the top
+\param      on    true to set the pixel
+*/
+void LCD_canvasPixel(struct LCDCanvas *c, uint8_t x, uint8_t y, bool on);
+
+/*!
+\brief   Draws a line.
+
+\param      c     The canvas
+\param      x0    Column of the start
+\param      y0    Row of the start
+\param      x1    Column of the end
+\param      y1    Row of the end
+\param      on    true to set the pixels, false to clear them
+*/
+void LCD_canvasLine(struct LCDCanvas *c, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, bool on);
+
+/*!
+\brief   Draws a sparkline over the whole canvas.
+\details Clears the canvas and joins the samples with lines, one sample per
+column starting at the left. Values are scaled so lo is the bottom row and
+hi the top row, samples past the width are ignored.
+
+\param      c      The canvas
+\param      values Samples, oldest first
+\param      n      Number of samples
+\param      lo     Value shown at the bottom
+\param      hi     Value shown at the top
+*/
+void LCD_canvasSparkline(struct LCDCanvas *c, const int16_t *values, uint8_t n, int16_t lo, int16_t hi);
+
+/*!
+\brief   Uploads the glyph rows that changed.
+\details Leaves the cursor at the top left cell of the canvas, set it again
+before writing text.
+
+\param      this  The LCD object reference
+\param      c     The canvas
+*/
+void LCD_canvasFlush(struct LCD *this, struct LCDCanvas *c);
+
+/** \brief Width of a canvas in pixels */
+#define LCD_canvasWidth(c)      ((c)->cols * 5)
+
+/** \brief Height of a canvas in pixels */
+#define LCD_canvasHeight(c)     ((c)->rows * 8)
+
+/** @} */
+
+#endif
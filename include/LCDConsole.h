@@ -0,0 +1,122 @@
+// ---------------------------------------------------------------------------
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// This software is furnished "as is", without technical support, and with no
+// warranty, express or implied, as to its usefulness for any purpose.
+//
+// Thread Safe: No
+// Extendable: Yes
+//
+// @file LCDConsole.h
+// Scrolling text console for the PIC LCD library.
+//
+// @brief
+// The console keeps the text of the screen in a RAM buffer and behaves as a
+// small terminal: text wraps at the end of a line and the screen scrolls up
+// when the last line is full. It understands \n (new line), \r, \b, \f
+// (clear screen) and a few ANSI sequences: ESC[row;colH (or f) to position
+// the cursor, ESC[K / ESC[1K / ESC[2K to clear the line, ESC[2J to clear the
+// screen and ESC[nA/B/C/D to move the cursor.
+// Only the characters that differ from what is on the LCD are sent, so on a
+// scroll the lines that don't change (e.g. blank ones) are not re-sent.
+//
+// Define LCD_CONSOLE_PUTCH to get a putch implementation writing to the
+// console pointed by LCD_stdout, XC8's printf then prints to the LCD.
+// ---------------------------------------------------------------------------
+#ifndef _LCD_CONSOLE_H_
+#define _LCD_CONSOLE_H_
+
+#include "LCD.h"
+
+/*!
+ @defined
+ @abstract   Maximum number of lines of a console.
+ */
+#define LCD_CONSOLE_MAXROWS     4
+
+/*!
+ \brief   State of a console
+ */
+struct LCDConsole {
+    struct LCD *lcd;
+
+    /** Text of the screen, numlines * cols chars, rows stored circularly */
+    char *buf;
+
+    /** Buffer row shown on the first line of the LCD */
+    uint8_t top;
+
+    /** Cursor position, col == cols means a wrap is pending */
+    uint8_t col;
+    uint8_t row;
+
+    /** Position where the LCD will write next, 0xFF if unknown */
+    uint8_t lcdCol;
+    uint8_t lcdRow;
+
+    /** Columns not yet sent to the LCD on each line, dmin > dmax if none */
+    uint8_t dmin[LCD_CONSOLE_MAXROWS];
+    uint8_t dmax[LCD_CONSOLE_MAXROWS];
+
+    /** ANSI escape sequence parser */
+    uint8_t esc;
+    uint8_t nparam;
+    uint8_t param[2];
+};
+
+/**
+ * \defgroup LCD_ConsoleFunctions LCD Console Functions
+ *
+ * @{
+ */
+
+/*!
+\brief   Initializes a console and clears the LCD.
+\details The console owns the LCD from now on, if something else writes to
+it call LCD_consoleRedraw afterwards.
+
+\param      con   The console
+\param      lcd   The LCD, already initialized with LCD_begin
+\param      buf   Buffer of lcd->numlines * lcd->cols chars
+*/
+void LCD_initConsole(struct LCDConsole *con, struct LCD *lcd, char *buf);
+
+/*!
+\brief   Writes a character to the console.
+\details Updates the buffer and sends the changed characters to the LCD.
+
+\param      con   The console
+\param      c     Character or control code
+*/
+void LCD_consolePutch(struct LCDConsole *con, char c);
+
+/*!
+\brief   Writes a NUL terminated string to the console.
+
+\param      con   The console
+\param      s     String to write
+*/
+void LCD_consolePrint(struct LCDConsole *con, const char *s);
+
+/*!
+\brief   Sends the whole buffer to the LCD again.
+
+\param      con   The console
+*/
+void LCD_consoleRedraw(struct LCDConsole *con);
+
+#ifdef LCD_CONSOLE_PUTCH
+/** Console written by putch */
+extern struct LCDConsole *LCD_stdout;
+
+/*!
+\brief   Character output used by printf.
+\param      c     Character to write to LCD_stdout
+*/
+void putch(char c);
+#endif
+
+/** @} */
+
+#endif
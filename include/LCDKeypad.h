@@ -0,0 +1,103 @@
+// ---------------------------------------------------------------------------
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// This software is furnished "as is", without technical support, and with no
+// warranty, express or implied, as to its usefulness for any purpose.
+//
+// Thread Safe: No
+// Extendable: Yes
+//
+// @file LCDKeypad.h
+// 4x4 keypad sharing the D4-D7 lines of a parallel LCD.
+//
+// @brief
+// The keypad rows are wired to D4-D7 of the LCD and the columns to four
+// consecutive input pins with pull-ups. While E is low the LCD ignores the
+// data lines, so a hook on the send method scans one keypad row right after
+// every byte sent, while the LCD executes it. The data port latch and
+// direction are saved before the transfer and restored after the scan, so
+// the application doesn't need to guard the LCD calls. A key changes state
+// when two scans of its row agree.
+//
+// During a scan only the row being scanned is driven (low), but every LCD
+// transfer drives D4-D7 with the bits of the byte. Two keys held in the same
+// column then connect two outputs at different levels, so put a series
+// resistor (e.g. 1k) on each row line between the keypad and the LCD data
+// line.
+//
+// With LCD_USE_TIMER the scan runs in the execution time of the byte, without
+// it the driver waits the execution time first and the scan adds to it.
+// ---------------------------------------------------------------------------
+#ifndef _LCD_KEYPAD_H_
+#define _LCD_KEYPAD_H_
+
+#include "LCD.h"
+
+/*!
+ \brief   State of a keypad
+ */
+struct LCDKeypad {
+    struct LCDHook hook;    // Must be the first member
+
+    /** LCD data port, its direction register and the column input port */
+    volatile uint8_t *dport;
+    volatile uint8_t *dtris;
+    volatile uint8_t *cols;
+
+    /** Data lines used by the LCD, and the shifts of D4 and column 0 */
+    uint8_t dataMask;
+    uint8_t rowShift;
+    uint8_t colShift;
+
+    /** Next row to scan */
+    uint8_t next;
+
+    /** Key bits: bit row * 4 + col */
+    uint16_t raw;       // Last scan
+    uint16_t keys;      // Debounced state, 1 for pressed
+    uint16_t pressed;   // Presses not read yet
+};
+
+/**
+ * \defgroup LCD_KeypadFunctions LCD Keypad Functions
+ *
+ * @{
+ */
+
+/*!
+\brief   Starts sharing the LCD data lines with a keypad.
+\details Only for LCDs initialized with LCD_initParallel or
+LCD_initParallelRW. Installs the send hook.
+
+\param      kp       The keypad
+\param      lcd      The LCD object reference
+\param      dtris    Direction register (TRIS) of the LCD data port
+\param      cols     Input port of the columns
+\param      colShift Pin of column 0, columns 1-3 are the next pins
+\return     false if the LCD doesn't use the parallel driver, nothing is installed
+*/
+bool LCD_initKeypad(struct LCDKeypad *kp, struct LCD *lcd, volatile uint8_t *dtris, volatile uint8_t *cols, uint8_t colShift);
+
+/*!
+\brief   Scans all the rows.
+\details Call it periodically when the LCD is idle, e.g. every 10ms. It must
+not interrupt an LCD call.
+
+\param      kp       The keypad
+*/
+void LCD_keypadScan(struct LCDKeypad *kp);
+
+/*!
+\brief   Returns the keys pressed since the last call.
+\param      kp       The keypad
+\return     Key bits, bit row * 4 + col
+*/
+uint16_t LCD_keypadPressed(struct LCDKeypad *kp);
+
+/** \brief Keys held down now, bit row * 4 + col */
+#define LCD_keypadKeys(kp)      ((kp)->keys)
+
+/** @} */
+
+#endif
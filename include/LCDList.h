@@ -0,0 +1,136 @@
+// ---------------------------------------------------------------------------
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// This software is furnished "as is", without technical support, and with no
+// warranty, express or implied, as to its usefulness for any purpose.
+//
+// Thread Safe: No
+// Extendable: Yes
+//
+// @file LCDList.h
+// Virtualized list view for menus with many entries.
+//
+// @brief
+// The list only knows the number of items and a callback that produces the
+// text of an item on demand, e.g. reading it from EEPROM, so the entries are
+// never held in RAM. Only the visible rows are rendered. When the selection
+// moves or the list scrolls, the old and new text of every row are compared
+// and only the cells that differ are sent, the display is never cleared.
+// The first column of each row shows the selection marker.
+// ---------------------------------------------------------------------------
+#ifndef _LCD_LIST_H_
+#define _LCD_LIST_H_
+
+#include "LCD.h"
+
+/*!
+ @defined
+ @abstract   Largest number of columns of a list row.
+ @discussion Two row buffers of this size are kept on the stack while drawing.
+ */
+#ifndef LCD_LIST_COLS
+#define LCD_LIST_COLS           20
+#endif
+
+/*!
+ @defined
+ @abstract   Largest number of rows of a list view.
+ */
+#ifndef LCD_LIST_ROWS
+#define LCD_LIST_ROWS           4
+#endif
+
+/*!
+ @defined
+ @abstract   Character marking the selected item.
+ */
+#ifndef LCD_LIST_MARKER
+#define LCD_LIST_MARKER         '>'
+#endif
+
+/*!
+ @defined
+ @abstract   Item index of a row with no item, past the end of the list.
+ */
+#define LCD_LIST_NONE           0xFFFF
+
+/*!
+ \brief   State of a list view
+ */
+struct LCDList {
+    /** Fills text with up to width chars of an item, NUL terminated if shorter */
+    void (*itemText)(uint16_t index, char *text, uint8_t width);
+
+    uint16_t count;
+    uint16_t top;           // Item shown in the first row
+    uint16_t selected;
+
+    /** LCD rows used by the list */
+    uint8_t row;
+    uint8_t rows;
+
+    /** Item and marker on screen in every row */
+    uint16_t shown[LCD_LIST_ROWS];
+    uint8_t markerRow;      // 0xFF if no row has it
+};
+
+/**
+ * \defgroup LCD_ListFunctions LCD List View Functions
+ *
+ * @{
+ */
+
+/*!
+\brief   Initializes a list view and draws it.
+\details The list takes the LCD rows row to row + rows - 1, which are fully
+rewritten. The first item is selected.
+
+\param      this     The LCD object reference
+\param      list     The list
+\param      row      First LCD row of the list
+\param      rows     Number of rows, up to LCD_LIST_ROWS
+\param      count    Number of items
+\param      itemText Callback producing the text of an item
+*/
+void LCD_initList(struct LCD *this, struct LCDList *list, uint8_t row, uint8_t rows, uint16_t count, void (*itemText)(uint16_t index, char *text, uint8_t width));
+
+/*!
+\brief   Selects an item, scrolling the list as little as possible.
+\details Only the cells that change are sent to the LCD.
+
+\param      this  The LCD object reference
+\param      list  The list
+\param      index Item to select, clamped to the last item
+*/
+void LCD_listSelect(struct LCD *this, struct LCDList *list, uint16_t index);
+
+/*!
+\brief   Redraws the rows whose item changed.
+\details Call it after changing count, top or the text of the items. Items
+whose text changed without moving are only redrawn by LCD_listRedraw.
+
+\param      this  The LCD object reference
+\param      list  The list
+*/
+void LCD_listUpdate(struct LCD *this, struct LCDList *list);
+
+/*!
+\brief   Rewrites all the rows of the list.
+
+\param      this  The LCD object reference
+\param      list  The list
+*/
+void LCD_listRedraw(struct LCD *this, struct LCDList *list);
+
+/** \brief Moves the selection to the next item */
+#define LCD_listDown(this, list)                                        \
+    LCD_listSelect(this, list, (list)->selected + 1)
+
+/** \brief Moves the selection to the previous item */
+#define LCD_listUp(this, list)                                          \
+    LCD_listSelect(this, list, ((list)->selected != 0) ? (list)->selected - 1 : 0)
+
+/** @} */
+
+#endif
@@ -0,0 +1,151 @@
+// ---------------------------------------------------------------------------
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// This software is furnished "as is", without technical support, and with no
+// warranty, express or implied, as to its usefulness for any purpose.
+//
+// Thread Safe: No
+// Extendable: Yes
+//
+// @file LCDMirror.h
+// Mirrors the display as a compact delta stream, e.g. over a UART.
+//
+// @brief
+// A hook on the send method turns every change of the display into a small
+// binary record written to a byte sink supplied by the application.
+// Consecutive data writes are coalesced into runs, cursor movements don't
+// produce anything since every run carries its address. The whole DDRAM is
+// mirrored, not only the visible cells, so text scrolled in with
+// LCD_scrollDisplayLeft/Right or autoscroll is there. A keyframe with the
+// whole DDRAM and the display shift is emitted periodically so a receiver
+// can join at any time.
+//
+// Stream format, records start with an opcode byte:
+//
+//   0x01-0x3F  DDRAM run of 1 to 63 chars: address, chars
+//   0x41-0x7F  CGRAM run of 1 to 63 bytes: CGRAM address, bytes
+//   0x80       Display control: flags (LCD_DISPLAYON, LCD_CURSORON, ...)
+//   0x81       Entry mode: flags (LCD_ENTRYLEFT, ...)
+//   0x82       Clear display
+//   0x83       Display shift: LCD_MOVERIGHT or LCD_MOVELEFT
+//   0x84       Return home, the display shift goes back to 0
+//   0xC0 'L' 'K' Keyframe: lines, cols, display control, entry mode, flags,
+//              display shift, 80 DDRAM chars, 64 CGRAM bytes if flags bit 0
+//              is set.
+//
+// Run addresses are always written left to right (ascending addresses).
+// Each DDRAM char written with LCD_ENTRYSHIFTINCREMENT in the entry mode
+// also shifts the display, like on the LCD. The display shift is in cells
+// to the right, 0 to the line length - 1 (40 cells for LCDs of more than one
+// line, 80 otherwise). The keyframe DDRAM is in address order: 0x00-0x27
+// then 0x40-0x67 for LCDs of more than one line, 0x00-0x4F otherwise.
+// The host side decoder is in host/LCDMirrorDecoder.h.
+// ---------------------------------------------------------------------------
+#ifndef _LCD_MIRROR_H_
+#define _LCD_MIRROR_H_
+
+#include "LCDTracker.h"
+
+/*!
+ @defined
+ @abstract   Maximum length of a coalesced run.
+ @discussion Longer runs are split, it is also the RAM used by the run buffer.
+ */
+#ifndef LCD_MIRROR_RUN
+#define LCD_MIRROR_RUN          20
+#endif
+
+#if LCD_MIRROR_RUN > 63
+#error "LCD_MIRROR_RUN must fit in the 6 bit run length"
+#endif
+
+/**
+ * \defgroup LCD_MirrorOps Mirror stream opcodes
+ *
+ * @{
+ */
+#define LCD_MIRROR_DDRAM        0x00
+#define LCD_MIRROR_CGRAM        0x40
+#define LCD_MIRROR_CONTROL      0x80
+#define LCD_MIRROR_ENTRY        0x81
+#define LCD_MIRROR_CLEAR        0x82
+#define LCD_MIRROR_SHIFT        0x83
+#define LCD_MIRROR_HOME         0x84
+#define LCD_MIRROR_KEYFRAME     0xC0
+/** @} */
+
+/*!
+ @defined
+ @abstract   Size of the DDRAM of the LCD, and of the shadow buffer.
+ */
+#define LCD_MIRROR_DDRAM_SIZE   80
+
+/*!
+ \brief   State of a display mirror
+ */
+struct LCDMirror {
+    struct LCDHook hook;    // Must be the first member
+    struct LCDTracker track;
+
+    /** Receives the stream, e.g. puts the byte in a UART TX ring buffer */
+    void (*sink)(uint8_t byte);
+
+    /** Copy of the DDRAM (LCD_MIRROR_DDRAM_SIZE) and CGRAM (64 or NULL) */
+    uint8_t *shadow;
+    uint8_t *cgram;
+
+    /** Display shift in cells to the right */
+    uint8_t shift;
+
+    /** Run being coalesced */
+    uint8_t run[LCD_MIRROR_RUN];
+    uint8_t runAddr;
+    uint8_t runLen;
+    bool runCgram;
+
+    /** Bytes of stream between keyframes, 0 for no periodic keyframes */
+    uint16_t keyframeEvery;
+    uint16_t sinceKeyframe;
+};
+
+/**
+ * \defgroup LCD_MirrorFunctions LCD Mirror Functions
+ *
+ * @{
+ */
+
+/*!
+\brief   Starts mirroring an LCD.
+\details Installs the send hook, clears the LCD so the mirror starts in sync
+and emits the first keyframe. Call it after LCD_begin.
+
+\param      m        The mirror
+\param      lcd      The LCD object reference
+\param      shadow   Buffer of LCD_MIRROR_DDRAM_SIZE bytes
+\param      cgram    Buffer of 64 bytes to include CGRAM in keyframes, or NULL
+\param      sink     Function receiving the stream bytes
+\param      keyframeEvery Bytes of stream between keyframes, 0 for none
+*/
+void LCD_initMirror(struct LCDMirror *m, struct LCD *lcd, uint8_t *shadow, uint8_t *cgram, void (*sink)(uint8_t byte), uint16_t keyframeEvery);
+
+/*!
+\brief   Emits the run being coalesced.
+\details Runs are emitted when a write doesn't continue them, call this at
+the end of an update so the receiver doesn't wait for the next change.
+
+\param      m        The mirror
+*/
+void LCD_mirrorFlush(struct LCDMirror *m);
+
+/*!
+\brief   Emits a keyframe now.
+
+\param      m        The mirror
+\param      lcd      The LCD object reference
+*/
+void LCD_mirrorKeyframe(struct LCDMirror *m, struct LCD *lcd);
+
+/** @} */
+
+#endif
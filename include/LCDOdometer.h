@@ -0,0 +1,112 @@
+// ---------------------------------------------------------------------------
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// This software is furnished "as is", without technical support, and with no
+// warranty, express or implied, as to its usefulness for any purpose.
+//
+// Thread Safe: No
+// Extendable: Yes
+//
+// @file LCDOdometer.h
+// Numeric fields that only resend the digits that changed.
+//
+// @brief
+// A counter or timer ticking once per second usually changes its last digit
+// only, but LCD_printUInt sends all of them every time. An odometer is a
+// right aligned numeric field that remembers the cells it put on the LCD and
+// sends only the ones that differ, a run of changed cells costs one address
+// command. Values wider than the field show their last digits, like an
+// odometer rolling over; a negative value keeps a cell for its sign.
+//
+// When the address counter of the LCD is known (pass the tracker of a hook
+// module such as LCDWatchdog or LCDMirror) the runs are written in the entry
+// direction that needs fewer address commands, counting the two entry mode
+// commands of a switch to LCD_rightToLeft and back. Otherwise the current
+// entry direction is used.
+// ---------------------------------------------------------------------------
+#ifndef _LCD_ODOMETER_H_
+#define _LCD_ODOMETER_H_
+
+#include "LCDTracker.h"
+
+/*!
+ @defined
+ @abstract   Maximum width of an odometer, a sign and 5 digits.
+ */
+#define LCD_ODOMETER_WIDTH      6
+
+/*!
+ \brief   State of an odometer
+ */
+struct LCDOdometer {
+    uint8_t col;
+    uint8_t row;
+    uint8_t width;
+
+    /** Fill of the unused cells on the left, ' ' or '0' */
+    uint8_t pad;
+
+    /** Cells on the LCD, left to right */
+    uint8_t shown[LCD_ODOMETER_WIDTH];
+
+    /** The cells are on the LCD */
+    bool valid;
+
+    /** Follows the address counter of the LCD, NULL if none */
+    const struct LCDTracker *track;
+};
+
+/**
+ * \defgroup LCD_OdometerFunctions LCD Odometer Functions
+ *
+ * @{
+ */
+
+/*!
+\brief   Initializes an odometer.
+\details Nothing is sent, the first value shown draws the whole field.
+
+\param      od    The odometer
+\param      col   Column of the first cell
+\param      row   Row of the field
+\param      width Number of cells, 1 to LCD_ODOMETER_WIDTH
+\param      pad   Fill of the unused cells on the left, ' ' or '0'
+\param      track Tracker of the LCD, NULL if none
+*/
+void LCD_initOdometer(struct LCDOdometer *od, uint8_t col, uint8_t row, uint8_t width, uint8_t pad,
+                      const struct LCDTracker *track);
+
+/*!
+\brief   Shows an unsigned value, sending only the cells that change.
+
+\param      this  The LCD object reference
+\param      od    The odometer
+\param      value Value to show
+*/
+void LCD_odometerUInt(struct LCD *this, struct LCDOdometer *od, uint16_t value);
+
+/*!
+\brief   Shows a signed value, sending only the cells that change.
+\details The sign goes right before the digits, or in the first cell when
+the pad is '0'. The sign is never dropped: when the digits fill the field
+the sign takes the first cell and the leading digit is dropped, a field of
+width 1 shows the sign alone.
+
+\param      this  The LCD object reference
+\param      od    The odometer
+\param      value Value to show
+*/
+void LCD_odometerSInt(struct LCD *this, struct LCDOdometer *od, int16_t value);
+
+/*!
+\brief   Forgets the cells on the LCD, e.g. after a clear.
+\details The next value shown draws the whole field.
+
+\param      od    The odometer
+*/
+#define LCD_odometerInvalidate(od)      ((od)->valid = false)
+
+/** @} */
+
+#endif
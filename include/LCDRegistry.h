@@ -0,0 +1,114 @@
+// ---------------------------------------------------------------------------
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// This software is furnished "as is", without technical support, and with no
+// warranty, express or implied, as to its usefulness for any purpose.
+//
+// Thread Safe: LCD_publish can be called from one interrupt routine
+// Extendable: Yes
+//
+// @file LCDRegistry.h
+// Live values for the fields of a screen template.
+//
+// @brief
+// Interrupt routines and fast loops publish values to the fields of a
+// template at any rate, only the latest value of each field is kept.
+// The main loop calls LCD_refreshFields, which renders the fields changed
+// since the last frame, no more often than the configured period and within
+// a bus time budget per frame. Fields with higher priority are rendered
+// first, the ones that don't fit in the budget are left for the next frame.
+// ---------------------------------------------------------------------------
+#ifndef _LCD_REGISTRY_H_
+#define _LCD_REGISTRY_H_
+
+#include "LCDTemplate.h"
+
+/*!
+ \brief   Latest value published to a template field
+ */
+struct LCDLiveField {
+    volatile uint16_t value;
+    volatile uint8_t dirty;
+    uint8_t priority;       // Higher values are rendered first
+};
+
+/*!
+ \brief   Live values of a screen template
+ */
+struct LCDRegistry {
+    const struct LCDTemplate *tpl;
+
+    /** One entry per field of the template */
+    struct LCDLiveField *fields;
+
+    /** Minimum time between frames, in the units of the refresh time base */
+    uint16_t period;
+
+    /** Bus time allowed per frame in microseconds */
+    uint16_t budget;
+
+    uint16_t lastFrame;
+};
+
+/**
+ * \defgroup LCD_RegistryFunctions LCD Field Registry Functions
+ *
+ * @{
+ */
+
+/*!
+\brief   Initializes a field registry.
+\details All fields start clean with priority 0. The template should be
+drawn with LCD_showTemplate before the first refresh.
+
+\param      reg     The registry
+\param      tpl     Template whose fields receive the values
+\param      fields  Array with one entry per template field
+\param      period  Minimum time between frames (e.g. 100 with a ms time base)
+\param      budget  Bus time allowed per frame in microseconds
+*/
+void LCD_initRegistry(struct LCDRegistry *reg, const struct LCDTemplate *tpl, struct LCDLiveField *fields, uint16_t period, uint16_t budget);
+
+/*!
+\brief   Publishes a value to a field.
+\details Only stores the value, nothing is sent to the LCD. Safe to call
+from an interrupt routine.
+
+\hideinitializer
+\param      reg   The registry
+\param      id    Field id
+\param      v     Value to show
+*/
+#define LCD_publish(reg, id, v)                 \
+    do {                                        \
+        (reg)->fields[id].value = (v);          \
+        (reg)->fields[id].dirty = 1;            \
+    } while (0)
+
+/*!
+\brief   Sets the rendering priority of a field.
+
+\hideinitializer
+\param      reg   The registry
+\param      id    Field id
+\param      p     Priority, higher values are rendered first
+*/
+#define LCD_setFieldPriority(reg, id, p)    ((reg)->fields[id].priority = (p))
+
+/*!
+\brief   Renders the fields published since the last frame.
+\details Does nothing until period has elapsed since the last frame. Then the
+dirty fields are rendered by priority while they fit in the bus time budget,
+at least one field is rendered per frame even if it exceeds the budget.
+
+\param      this  The LCD object reference
+\param      reg   The registry
+\param      now   Current time in the same units as period
+\return     true if a frame was rendered
+*/
+bool LCD_refreshFields(struct LCD *this, struct LCDRegistry *reg, uint16_t now);
+
+/** @} */
+
+#endif
@@ -0,0 +1,92 @@
+// ---------------------------------------------------------------------------
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// This software is furnished "as is", without technical support, and with no
+// warranty, express or implied, as to its usefulness for any purpose.
+//
+// Thread Safe: No
+// Extendable: Yes
+//
+// @file LCDSource.h
+// Printing from any source of characters without a RAM copy.
+//
+// @brief
+// A source hands out the characters of a text one at a time and
+// LCD_printSource streams them straight into the driver, so text kept in
+// program flash, data EEPROM or a ring buffer doesn't have to be copied into
+// a RAM buffer first. Other sources are made by setting the next method,
+// keeping their own data in a struct whose first member is the LCDSource.
+// ---------------------------------------------------------------------------
+#ifndef _LCD_SOURCE_H_
+#define _LCD_SOURCE_H_
+
+#include "LCD.h"
+
+/*!
+ \brief   A source of characters
+ */
+struct LCDSource {
+    /** Returns the next character and advances, '\0' at the end of the text */
+    uint8_t (*next)(struct LCDSource *src);
+
+    /** State of the built-in sources */
+    const uint8_t *data;
+    uint16_t pos;
+    uint16_t size;
+};
+
+/**
+ * \defgroup LCD_SourceFunctions LCD Source Functions
+ *
+ * @{
+ */
+
+/*!
+\brief   Makes a source of a NUL terminated string.
+\details On XC8 a const string stays in program flash and is read from there.
+
+\param      src The source
+\param      s   The string
+*/
+void LCD_sourceString(struct LCDSource *src, const char *s);
+
+/*!
+\brief   Makes a source of the contents of a ring buffer.
+\details Characters are read from start on, wrapping at the end of the
+buffer. The buffer is not modified, bound the text with the length given
+to LCD_printSource.
+
+\param      src   The source
+\param      buf   The ring buffer
+\param      size  Size of the ring buffer
+\param      start Index of the first character
+*/
+void LCD_sourceRing(struct LCDSource *src, const uint8_t *buf, uint16_t size, uint16_t start);
+
+#if defined(_EEPROMSIZE) && _EEPROMSIZE > 0
+/*!
+\brief   Makes a source of a NUL terminated string in data EEPROM.
+\details Only on devices with data EEPROM.
+
+\param      src  The source
+\param      addr EEPROM address of the string
+*/
+void LCD_sourceEeprom(struct LCDSource *src, uint16_t addr);
+#endif
+
+/*!
+\brief   Prints the characters of a source.
+\details Stops at the end of the text or after maxlen characters, whichever
+comes first.
+
+\param      this   The LCD object reference
+\param      src    The source
+\param      maxlen Largest number of characters to print
+\return     Number of characters printed
+*/
+uint8_t LCD_printSource(struct LCD *this, struct LCDSource *src, uint8_t maxlen);
+
+/** @} */
+
+#endif
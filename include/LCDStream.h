@@ -0,0 +1,91 @@
+// ---------------------------------------------------------------------------
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// This software is furnished "as is", without technical support, and with no
+// warranty, express or implied, as to its usefulness for any purpose.
+//
+// Thread Safe: No
+// Extendable: Yes
+//
+// @file LCDStream.h
+// Pre-encoded command streams for fixed screens.
+//
+// @brief
+// Fixed screens such as splash, alarm and help pages can be written as a
+// const byte array built with the macros below. The compiler evaluates the
+// addresses and commands, XC8 keeps the array in program memory and
+// LCD_playStream sends it as it is: no formatting or cursor arithmetic is
+// done at run time. The bytes still go through the send method so hooks see
+// them.
+//
+// Stream format: data bytes as they are, a command is LCD_STREAM_ESCAPE
+// followed by the command byte. A data byte 0xFE is encoded as 0xFE 0x00,
+// 0x00 being an instruction that the library never sends (LCD_S_FE).
+// Characters are listed one by one, e.g. 'O', 'K'.
+//
+// Put the custom glyphs first and one LCD_S_GOTO per run of text, blanks
+// already on screen after LCD_S_CLEAR don't need to be sent.
+// ---------------------------------------------------------------------------
+#ifndef _LCD_STREAM_H_
+#define _LCD_STREAM_H_
+
+#include "LCD.h"
+
+/*!
+ @defined
+ @abstract   Escape byte of a stream.
+ @discussion The next byte is a command, or a data byte 0xFE if it is 0x00.
+ */
+#define LCD_STREAM_ESCAPE       0xFE
+
+/**
+ * \defgroup LCD_StreamMacros Stream building macros
+ *
+ * @{
+ */
+
+/** \brief Any command, e.g. LCD_S_CMD(LCD_DISPLAYCONTROL | LCD_DISPLAYON) */
+#define LCD_S_CMD(value)        LCD_STREAM_ESCAPE, (value)
+
+/** \brief Clear display, the playback waits the clear execution time */
+#define LCD_S_CLEAR             LCD_S_CMD(LCD_CLEARDISPLAY)
+
+/** \brief Return home, the playback waits the home execution time */
+#define LCD_S_HOME              LCD_S_CMD(LCD_RETURNHOME)
+
+/** \brief The character 0xFE, which can't be listed as it is */
+#define LCD_S_FE                LCD_STREAM_ESCAPE, 0x00
+
+/** \brief Row address of an LCD of the given geometry, same as LCD_rowAddress */
+#define LCD_S_ROW(row, cols, lines)                                     \
+    (((row) == 0) ? 0x00 : ((row) == 1) ? 0x40 :                        \
+     ((cols) == 16 && (lines) == 4) ? (((row) == 2) ? 0x10 : 0x50) :    \
+     (((row) == 2) ? 0x14 : 0x54))
+
+/** \brief Move the cursor, for an LCD of cols x lines */
+#define LCD_S_GOTO(col, row, cols, lines)                               \
+    LCD_S_CMD(LCD_SETDDRAMADDR | ((col) + LCD_S_ROW(row, cols, lines)))
+
+/** \brief Define a custom glyph, then go back to DDRAM with LCD_S_GOTO */
+#define LCD_S_GLYPH(location, r0, r1, r2, r3, r4, r5, r6, r7)           \
+    LCD_S_CMD(LCD_SETCGRAMADDR | (((location) & 0x07) << 3)),           \
+    (r0), (r1), (r2), (r3), (r4), (r5), (r6), (r7)
+
+/** @} */
+
+/*!
+\brief   Plays a stream.
+\details Sends the bytes of a stream in order, waiting the execution time
+of clear and home. Display control, entry mode and function set commands
+are copied to the LCD object, so the functions that change one bit keep
+the others as the stream left them. An escape in the last byte has no
+command and is ignored.
+
+\param      this   The LCD object reference
+\param      stream The stream
+\param      len    Length of the stream in bytes, e.g. sizeof(splash)
+*/
+void LCD_playStream(struct LCD *this, const uint8_t *stream, uint16_t len);
+
+#endif
@@ -0,0 +1,104 @@
+// ---------------------------------------------------------------------------
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// This software is furnished "as is", without technical support, and with no
+// warranty, express or implied, as to its usefulness for any purpose.
+//
+// Thread Safe: No
+// Extendable: Yes
+//
+// @file LCDTemplate.h
+// Screen templates for the PIC LCD library.
+//
+// @brief
+// A template describes a whole screen as constant tables: the static text of
+// every row plus a list of field slots (position, width and alignment).
+// Being const, XC8 places the tables in program memory, so no RAM copy of
+// the labels is needed. The static text is drawn once by LCD_showTemplate,
+// afterwards LCD_setField only rewrites the cells of the given field.
+// ---------------------------------------------------------------------------
+#ifndef _LCD_TEMPLATE_H_
+#define _LCD_TEMPLATE_H_
+
+#include "LCD.h"
+
+/**
+ * \defgroup LCD_FieldAlign Field alignment flags
+ *
+ * @{
+ */
+#define LCD_ALIGN_LEFT          0x00
+#define LCD_ALIGN_RIGHT         0x01
+/** @} */
+
+/*!
+ \brief   A field slot inside a screen template
+ */
+struct LCDField {
+    uint8_t col;
+    uint8_t row;
+    uint8_t width;
+    uint8_t align;  // LCD_ALIGN_LEFT or LCD_ALIGN_RIGHT
+};
+
+/*!
+ \brief   A screen template, intended to be declared const
+ */
+struct LCDTemplate {
+    /** Static text of each row, NULL for an empty row */
+    const char * const *rows;
+    uint8_t numrows;
+
+    /** Field slots, the field id is the index in this table */
+    const struct LCDField *fields;
+
+    uint8_t numfields;
+};
+
+/**
+ * \defgroup LCD_TemplateFunctions LCD Screen Template Functions
+ *
+ * @{
+ */
+
+/*!
+\brief   Draws the static text of a template.
+\details Clears the LCD and writes the static text of every row, rows
+beyond the template or the LCD are left blank. Runs of blanks are skipped
+with a cursor jump instead of being sent, the display is already blank
+after the clear. Fields are left empty until they are set with
+LCD_setField.
+
+\param      this The LCD object reference
+\param      tpl  The template to draw
+*/
+void LCD_showTemplate(struct LCD *this, const struct LCDTemplate *tpl);
+
+/*!
+\brief   Updates a field of the template on screen.
+\details Writes value in the cells of the given field, aligned and padded
+with blanks up to the field width. Values longer than the field are
+truncated. No other cell of the display is touched.
+
+\param      this  The LCD object reference
+\param      tpl   The template currently on screen
+\param      id    Field id (index in the fields table)
+\param      value NUL terminated string to show
+*/
+void LCD_setField(struct LCD *this, const struct LCDTemplate *tpl, uint8_t id, const char *value);
+
+/*!
+\brief   Updates a field of the template on screen with an unsigned integer.
+\details Same as LCD_setField but formats an unsigned integer value.
+
+\param      this  The LCD object reference
+\param      tpl   The template currently on screen
+\param      id    Field id (index in the fields table)
+\param      value Value to show
+*/
+void LCD_setFieldUInt(struct LCD *this, const struct LCDTemplate *tpl, uint8_t id, uint16_t value);
+
+/** @} */
+
+#endif
@@ -0,0 +1,74 @@
+// ---------------------------------------------------------------------------
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// This software is furnished "as is", without technical support, and with no
+// warranty, express or implied, as to its usefulness for any purpose.
+//
+// Thread Safe: No
+// Extendable: Yes
+//
+// @file LCDTracker.h
+// Tracks the state of the LCD controller from the bytes sent to it.
+//
+// @brief
+// Modules hooked on the send method (see LCD_addHook) use a tracker to know
+// where each data byte lands: the address counter is followed through the
+// address, home, clear and cursor shift commands and the entry mode, the
+// same way the HD44780 does.
+// ---------------------------------------------------------------------------
+#ifndef _LCD_TRACKER_H_
+#define _LCD_TRACKER_H_
+
+#include "LCD.h"
+
+/*!
+ \brief   LCD controller state as seen from the bytes sent
+ */
+struct LCDTracker {
+    uint8_t addr;       // Address counter
+    bool cgram;         // The address counter points to CGRAM
+    uint8_t control;    // Last display control flags sent
+    uint8_t entry;      // Last entry mode flags sent
+};
+
+/**
+ * \defgroup LCD_TrackerFunctions LCD Tracker Functions
+ *
+ * @{
+ */
+
+/*!
+\brief   Initializes a tracker.
+\details The address counter is assumed to be at the start of DDRAM and the
+registers to be the ones stored in the LCD object.
+
+\param      t     The tracker
+\param      lcd   The LCD object reference
+*/
+void LCD_initTracker(struct LCDTracker *t, struct LCD *lcd);
+
+/*!
+\brief   Updates the tracker with a byte sent to the LCD.
+\details For data bytes, the address they are written at is the one in the
+tracker before this call.
+
+\param      t     The tracker
+\param      lcd   The LCD object reference
+\param      value Byte sent
+\param      mode  COMMAND or DATA
+*/
+void LCD_track(struct LCDTracker *t, struct LCD *lcd, uint8_t value, uint8_t mode);
+
+/*!
+\brief   Position of a DDRAM address on screen.
+
+\param      lcd   The LCD object reference
+\param      addr  DDRAM address
+\return     row * cols + col of the cell shown at addr, 0xFF if not visible
+*/
+uint8_t LCD_cellIndex(struct LCD *lcd, uint8_t addr);
+
+/** @} */
+
+#endif
@@ -0,0 +1,111 @@
+// ---------------------------------------------------------------------------
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// This software is furnished "as is", without technical support, and with no
+// warranty, express or implied, as to its usefulness for any purpose.
+//
+// Thread Safe: Yes, with a lock
+// Extendable: Yes
+//
+// @file LCDTransaction.h
+// Atomic display updates for multi-task firmware.
+//
+// @brief
+// A multi-step update such as LCD_setCursor + LCD_printString can be
+// interleaved by another task, garbling the screen. A transaction is a view
+// of the LCD, a copy of the LCD object whose send method records the bytes
+// in a buffer instead of sending them. The task draws on the view with the
+// usual functions and LCD_commit sends the recorded bytes in one burst while
+// holding the lock, so the lock is held for one transfer and not across the
+// whole update.
+//
+// Every task uses its own transaction. Only the drawing functions may be
+// used on the view: LCD_begin, LCD_resync and reads act on the hardware
+// directly.
+//
+// The buffer holds a stream in the format of LCDStream.h.
+// ---------------------------------------------------------------------------
+#ifndef _LCD_TRANSACTION_H_
+#define _LCD_TRANSACTION_H_
+
+#include "LCDStream.h"
+
+/*!
+ \brief   A lock shared by all the tasks using an LCD
+ \details E.g. an RTOS mutex or a pthread mutex on the host. On bare metal
+ firmware where an interrupt handler draws on the LCD, acquire and release
+ can disable and enable interrupts.
+ */
+struct LCDLock {
+    void (*acquire)(void *ctx);
+    void (*release)(void *ctx);
+    void *ctx;
+};
+
+/*!
+ \brief   State of a transaction
+ */
+struct LCDTransaction {
+    /** View to draw on, must be the first member */
+    struct LCD view;
+
+    /** The LCD updated by the transaction */
+    struct LCD *lcd;
+    const struct LCDLock *lock;
+
+    /** Recorded bytes */
+    uint8_t *buf;
+    uint8_t size;
+    uint8_t len;
+
+    /** The lock is held since the buffer filled up */
+    bool locked;
+
+    /** Mode registers of the LCD when the transaction began */
+    uint8_t basefunction;
+    uint8_t basecontrol;
+    uint8_t basemode;
+
+    /** Bits of the mode registers changed by the transaction */
+    uint8_t changedfunction;
+    uint8_t changedcontrol;
+    uint8_t changedmode;
+};
+
+/**
+ * \defgroup LCD_TransactionFunctions LCD Transaction Functions
+ *
+ * @{
+ */
+
+/*!
+\brief   Starts a transaction.
+\details The view takes the current state of the LCD. Draw on tx->view,
+e.g. LCD_setCursor(&tx.view, 0, 1), and call LCD_commit at the end.
+If the buffer fills up the recorded bytes are sent and the lock is kept
+until the commit, the update stays atomic but the lock is held longer.
+
+\param      tx    The transaction
+\param      lcd   The LCD object reference
+\param      lock  The lock of the LCD, NULL for none
+\param      buf   Buffer for the recorded bytes
+\param      size  Size of the buffer, at least 2 bytes
+*/
+void LCD_beginTransaction(struct LCDTransaction *tx, struct LCD *lcd, const struct LCDLock *lock, uint8_t *buf, uint8_t size);
+
+/*!
+\brief   Sends the recorded bytes and ends the transaction.
+\details The display control, entry mode and function set bits changed on
+the view are copied back to the LCD object. The other bits keep their live
+value, so a mode change committed by another task meanwhile is not undone:
+the mode commands recorded are merged with the live state when they are
+sent.
+
+\param      tx    The transaction
+*/
+void LCD_commit(struct LCDTransaction *tx);
+
+/** @} */
+
+#endif
@@ -0,0 +1,75 @@
+// ---------------------------------------------------------------------------
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// This software is furnished "as is", without technical support, and with no
+// warranty, express or implied, as to its usefulness for any purpose.
+//
+// Thread Safe: No
+// Extendable: Yes
+//
+// @file LCDUtf8.h
+// UTF-8 text output for the PIC LCD library.
+//
+// @brief
+// Code points are transcoded to the character ROM of the module through a
+// small lookup table kept in program memory. The HD44780 comes with two ROM
+// versions, A00 (Japanese, the most common one) and A02 (European), define
+// LCD_ROM_A02 when compiling to select the latter.
+// Characters that the ROM lacks but that are available in the built-in font
+// (Spanish accented letters, inverted marks, euro sign, ...) are uploaded to
+// CGRAM on demand and tracked by a glyph cache.
+// ---------------------------------------------------------------------------
+#ifndef _LCD_UTF8_H_
+#define _LCD_UTF8_H_
+
+#include "LCD.h"
+
+/*!
+ \brief   Tracks which code point is loaded in each CGRAM slot
+ */
+struct LCDGlyphCache {
+    uint16_t glyph[8];  // Code point loaded in each slot, 0 if free
+    uint8_t first;      // First CGRAM slot managed by the cache
+    uint8_t count;      // Number of slots managed by the cache
+    uint8_t next;       // Next slot to recycle (round robin)
+};
+
+/**
+ * \defgroup LCD_Utf8Functions LCD UTF-8 Functions
+ *
+ * @{
+ */
+
+/*!
+\brief   Initializes a glyph cache.
+\details The cache manages CGRAM slots first to first+count-1, the remaining
+slots are left for the application to use with LCD_createChar.
+
+\param      cache The glyph cache
+\param      first First CGRAM slot to use (0 to 7)
+\param      count Number of slots to use
+*/
+void LCD_initGlyphCache(struct LCDGlyphCache *cache, uint8_t first, uint8_t count);
+
+/*!
+\brief   Writes a UTF-8 string to the LCD.
+\details Glyphs missing from the character ROM are uploaded to CGRAM first,
+then the text is written at the given position. Slots used by the string
+are never recycled while it is printed, when the string needs more glyphs
+than there are slots the remaining characters are replaced by their
+unaccented form. Glyphs written by a previous call can change on screen if
+their slot gets recycled, so give the cache enough slots for a screen.
+Code points that can't be shown at all are written as '?'.
+
+\param      this  The LCD object reference
+\param      cache The glyph cache of this LCD
+\param      col   LCD column
+\param      row   LCD row - line
+\param      s     NUL terminated UTF-8 string
+*/
+void LCD_printUtf8(struct LCD *this, struct LCDGlyphCache *cache, uint8_t col, uint8_t row, const char *s);
+
+/** @} */
+
+#endif
@@ -0,0 +1,81 @@
+// ---------------------------------------------------------------------------
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// This software is furnished "as is", without technical support, and with no
+// warranty, express or implied, as to its usefulness for any purpose.
+//
+// Thread Safe: No
+// Extendable: Yes
+//
+// @file LCDWatchdog.h
+// Display integrity watchdog for the PIC LCD library.
+//
+// @brief
+// Noise on long cables can take a 4 bit LCD out of nibble sync or corrupt
+// its DDRAM. The watchdog keeps a shadow copy of the DDRAM, fed by a hook on
+// the send method, and repairs the LCD in the background: every call to
+// LCD_watchdogTick sends a slice of the repair cycle, bounded by a bus time
+// budget. A cycle resynchronizes the interface, re-asserts function set,
+// display control and entry mode, and then re-sends the rows from the
+// shadow copy one slice at a time. When the LCD has the RW pin connected the
+// rows are read back first and only the cells that differ are re-sent.
+// The address counter is restored after every slice, so the application
+// doesn't notice the ticks. Display shifts are not tracked.
+// ---------------------------------------------------------------------------
+#ifndef _LCD_WATCHDOG_H_
+#define _LCD_WATCHDOG_H_
+
+#include "LCDTracker.h"
+
+/*!
+ \brief   State of a display watchdog
+ */
+struct LCDWatchdog {
+    struct LCDHook hook;    // Must be the first member
+
+    /** Copy of the visible DDRAM, numlines * cols bytes */
+    uint8_t *shadow;
+
+    /** Bus time allowed per tick in microseconds */
+    uint16_t budget;
+
+    /** LCD state as tracked from the bytes sent */
+    struct LCDTracker track;
+
+    /** Repair cycle position: 0 for the registers, else row + 1 and column */
+    uint8_t step;
+    uint8_t col;
+};
+
+/**
+ * \defgroup LCD_WatchdogFunctions LCD Watchdog Functions
+ *
+ * @{
+ */
+
+/*!
+\brief   Starts watching an LCD.
+\details Installs the send hook and clears the LCD, so the shadow copy
+starts in sync. Call it after LCD_begin.
+
+\param      wd      The watchdog
+\param      lcd     The LCD object reference
+\param      shadow  Buffer of lcd->numlines * lcd->cols bytes
+\param      budget  Bus time allowed per tick in microseconds
+*/
+void LCD_initWatchdog(struct LCDWatchdog *wd, struct LCD *lcd, uint8_t *shadow, uint16_t budget);
+
+/*!
+\brief   Runs a slice of the repair cycle.
+\details Call it periodically from the main loop, at least one step is done
+per tick even if it doesn't fit in the budget.
+
+\param      wd      The watchdog
+\param      lcd     The LCD object reference
+*/
+void LCD_watchdogTick(struct LCDWatchdog *wd, struct LCD *lcd);
+
+/** @} */
+
+#endif
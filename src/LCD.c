@@ -35,8 +35,6 @@
 #include <stdio.h>
 #include "LCD.h"
 
-uint8_t digit[6];
-
 // PUBLIC METHODS
 // ---------------------------------------------------------------------------
 // When the display powers up, it is configured as follows:
@@ -60,21 +58,223 @@ uint8_t digit[6];
 // A call to begin() will reinitialize the LCD.
 //
 
+#ifdef LCD_TIMER_TMR1
+uint16_t LCD_readTMR1(void)
+{
+    uint8_t high, low;
+
+    do {
+        high = TMR1H;
+        low = TMR1L;
+    } while (high != TMR1H);
+
+    return ((uint16_t)high << 8) | low;
+}
+#endif
+
+#ifdef LCD_USE_TIMER
+// Wait for the pending execution time. Only differences up to the longest
+// execution time are considered pending, a larger one means the deadline has
+// passed long ago and the 16 bit timer has wrapped since then.
+void LCD_waitReady(struct LCD *this)
+{
+    uint16_t remaining;
+
+    do {
+        remaining = this->readyAt - LCD_timerNow();
+    } while (remaining != 0 && remaining <= LCD_homeClearTime(this));
+}
+#endif
+
+#ifdef LCD_CALIBRATE
+// Timing profile
+// ---------------------------------------------------------------------------
+#define BUSY_FLAG       0x80
+
+// Longest wait for the busy flag to clear
+#define CAL_TIMEOUT     (4 * HOME_CLEAR_EXEC)
+
+void LCD_defaultTiming(struct LCD *this)
+{
+    this->timing.write = EXEC_TIME;
+    this->timing.address = EXEC_TIME;
+    this->timing.homeClear = HOME_CLEAR_EXEC;
+    this->timing.cgram = EXEC_TIME;
+    this->cgram = false;
+}
+
+uint16_t LCD_execTime(struct LCD *this, uint8_t value, uint8_t mode)
+{
+    if (mode == DATA)
+        return this->cgram ? this->timing.cgram : this->timing.write;
+
+    if (value & LCD_SETDDRAMADDR) {
+        this->cgram = false;
+    } else if (value & LCD_SETCGRAMADDR) {
+        this->cgram = true;
+    } else if (value < LCD_ENTRYMODESET) {
+        // Clear and home, both go back to DDRAM address 0
+        this->cgram = false;
+        return this->timing.homeClear;
+    }
+    return this->timing.address;
+}
+
+// Time until the busy flag clears, 0 on timeout. The end is taken before the
+// read that finds the flag clear, the time of that read is not counted.
+static uint16_t settle(struct LCD *this)
+{
+    uint16_t start = LCD_timerNow();
+    uint16_t elapsed;
+
+    this->readyAt = start;      // poll right away
+
+    do {
+        elapsed = LCD_timerNow() - start;
+        if (elapsed > CAL_TIMEOUT)
+            return 0;
+    } while (this->read(this, COMMAND) & BUSY_FLAG);
+
+    return elapsed;
+}
+
+// Send a byte and time its execution
+static uint16_t measure(struct LCD *this, uint8_t value, uint8_t mode)
+{
+    LCD_send(this, value, mode);
+    return settle(this);
+}
+
+// Keep the slowest sample, a timeout or a busy flag too fast to be true spoil the calibration
+static void keep(uint16_t *slowest, uint16_t sample, bool *trusted)
+{
+    if (sample < LCD_CAL_MIN)
+        *trusted = false;
+    if (sample > *slowest)
+        *slowest = sample;
+}
+
+static uint16_t withMargin(uint16_t t)
+{
+    return (uint16_t)(t + (uint32_t)t * LCD_CAL_MARGIN / 100);
+}
+
+void LCD_calibrate(struct LCD *this)
+{
+    struct LCDTiming t = { 0, 0, 0, 0 };
+    bool trusted = true;
+    uint8_t i, value;
+
+    if (this->read == NULL)
+        return;
+
+    for (i = 0; i < LCD_CAL_SAMPLES; i++) {
+        keep(&t.homeClear, measure(this, LCD_CLEARDISPLAY, COMMAND), &trusted);
+        keep(&t.homeClear, measure(this, LCD_RETURNHOME, COMMAND), &trusted);
+        keep(&t.address, measure(this, LCD_SETDDRAMADDR, COMMAND), &trusted);
+
+        // Write back what the RAM holds, the profile is not known yet so
+        // every access waits for the busy flag
+        value = this->read(this, DATA);
+        settle(this);
+        measure(this, LCD_SETDDRAMADDR, COMMAND);
+        keep(&t.write, measure(this, value, DATA), &trusted);
+
+        measure(this, LCD_SETCGRAMADDR, COMMAND);
+        value = this->read(this, DATA);
+        settle(this);
+        measure(this, LCD_SETCGRAMADDR, COMMAND);
+        keep(&t.cgram, measure(this, value, DATA), &trusted);
+    }
+    measure(this, LCD_SETDDRAMADDR, COMMAND);
+
+    if (!trusted)
+        return;
+
+    this->timing.write = withMargin(t.write);
+    this->timing.address = withMargin(t.address);
+    this->timing.cgram = withMargin(t.cgram);
+
+    // Also the longest wait LCD_waitReady accepts, keep the fixed waits below it
+    t.homeClear = withMargin(t.homeClear);
+    this->timing.homeClear = (t.homeClear > EXEC_TIME) ? t.homeClear : EXEC_TIME;
+}
+#endif
+
+// Send hooks
+// ---------------------------------------------------------------------------
+static void hookedSend(struct LCD *this, uint8_t value, uint8_t mode)
+{
+    this->hook->send(this->hook, this, value, mode);
+}
+
+void LCD_addHook(struct LCD *this, struct LCDHook *hook, void (*send)(struct LCDHook *hook, struct LCD *lcd, uint8_t value, uint8_t mode))
+{
+    hook->send = send;
+    hook->below = this->hook;
+    hook->driverSend = (this->hook == NULL) ? this->send : this->hook->driverSend;
+
+    this->hook = hook;
+    this->send = &hookedSend;
+}
+
+void LCD_hookForward(struct LCDHook *hook, struct LCD *lcd, uint8_t value, uint8_t mode)
+{
+    if (hook->below != NULL)
+        hook->below->send(hook->below, lcd, value, mode);
+    else
+        hook->driverSend(lcd, value, mode);
+}
+
+// Mode registers
+// ---------------------------------------------------------------------------
+#ifdef LCD_LAZY_MODES
+// Sent by LCD_flushModes
+#define controlChanged(this)
+#define modeChanged(this)
+
+void LCD_syncModes(struct LCD *this)
+{
+    if (this->displaycontrol != this->sentcontrol) {
+        this->sentcontrol = this->displaycontrol;
+        LCD_command(this, LCD_DISPLAYCONTROL | this->displaycontrol);
+    }
+    if (this->displaymode != this->sentmode) {
+        this->sentmode = this->displaymode;
+        LCD_command(this, LCD_ENTRYMODESET | this->displaymode);
+    }
+}
+
+void LCD_writeData(struct LCD *this, uint8_t value)
+{
+    LCD_flushModes(this);
+    LCD_send(this, value, DATA);
+}
+#else
+#define controlChanged(this)    LCD_command(this, LCD_DISPLAYCONTROL | (this)->displaycontrol)
+#define modeChanged(this)       LCD_command(this, LCD_ENTRYMODESET | (this)->displaymode)
+#endif
+
 // Common LCD Commands
 // ---------------------------------------------------------------------------
 void LCD_clear(struct LCD *this)
 {
    LCD_command(this, LCD_CLEARDISPLAY);     // clear display, set cursor position to zero
-   __delay_us(HOME_CLEAR_EXEC);             // this command is time consuming
+   if (!LCD_isQueued(this))
+      LCD_setBusy(this, LCD_homeClearTime(this));   // this command is time consuming
+#ifdef LCD_LAZY_MODES
+   this->sentmode |= LCD_ENTRYLEFT;         // the LCD goes back to increment mode
+#endif
 }
 
 void LCD_home(struct LCD *this)
 {
    LCD_command(this, LCD_RETURNHOME);   // set cursor position to zero
-   __delay_us(HOME_CLEAR_EXEC);         // This command is time consuming
+   if (!LCD_isQueued(this))
+      LCD_setBusy(this, LCD_homeClearTime(this));   // This command is time consuming
 }
 
-void LCD_setCursor(struct LCD *this, uint8_t col, uint8_t row)
+uint8_t LCD_rowAddress(struct LCD *this, uint8_t row)
 {
    const byte row_offsetsDef[]   = { 0x00, 0x40, 0x14, 0x54 }; // For regular LCDs
    const byte row_offsetsLarge[] = { 0x00, 0x40, 0x10, 0x50 }; // For 16x4 LCDs
@@ -88,51 +288,55 @@ void LCD_setCursor(struct LCD *this, uint8_t col, uint8_t row)
    // ----------------------------------------
    if ( this->cols == 16 && this->numlines == 4 )
    {
-      LCD_command(this, LCD_SETDDRAMADDR | (col + row_offsetsLarge[row]));
+      return row_offsetsLarge[row];
    }
    else 
    {
-      LCD_command(this, LCD_SETDDRAMADDR | (col + row_offsetsDef[row]));
+      return row_offsetsDef[row];
    }
-   
+}
+
+void LCD_setCursor(struct LCD *this, uint8_t col, uint8_t row)
+{
+   LCD_command(this, LCD_SETDDRAMADDR | (col + LCD_rowAddress(this, row)));
 }
 
 // Turn the display on/off
 void LCD_noDisplay(struct LCD *this)
 {
    this->displaycontrol &= ~LCD_DISPLAYON;
-   LCD_command(this, LCD_DISPLAYCONTROL | this->displaycontrol);
+   controlChanged(this);
 }
 
 void LCD_display(struct LCD *this)
 {
    this->displaycontrol |= LCD_DISPLAYON;
-   LCD_command(this, LCD_DISPLAYCONTROL | this->displaycontrol);
+   controlChanged(this);
 }
 
 // Turns the underline cursor on/off
 void LCD_noCursor(struct LCD *this)
 {
    this->displaycontrol &= ~LCD_CURSORON;
-   LCD_command(this, LCD_DISPLAYCONTROL | this->displaycontrol);
+   controlChanged(this);
 }
 void LCD_cursor(struct LCD *this)
 {
    this->displaycontrol |= LCD_CURSORON;
-   LCD_command(this, LCD_DISPLAYCONTROL | this->displaycontrol);
+   controlChanged(this);
 }
 
 // Turns on/off the blinking cursor
 void LCD_noBlink(struct LCD *this)
 {
    this->displaycontrol &= ~LCD_BLINKON;
-   LCD_command(this, LCD_DISPLAYCONTROL | this->displaycontrol);
+   controlChanged(this);
 }
 
 void LCD_blink(struct LCD *this)
 {
    this->displaycontrol |= LCD_BLINKON;
-   LCD_command(this, LCD_DISPLAYCONTROL | this->displaycontrol);
+   controlChanged(this);
 }
 
 // These commands scroll the display without changing the RAM
@@ -150,14 +354,14 @@ void LCD_scrollDisplayRight(struct LCD *this)
 void LCD_leftToRight(struct LCD *this)
 {
    this->displaymode |= LCD_ENTRYLEFT;
-   LCD_command(this, LCD_ENTRYMODESET | this->displaymode);
+   modeChanged(this);
 }
 
 // This is for text that flows Right to Left
 void LCD_rightToLeft(struct LCD *this)
 {
    this->displaymode &= ~LCD_ENTRYLEFT;
-   LCD_command(this, LCD_ENTRYMODESET | this->displaymode);
+   modeChanged(this);
 }
 
 // This method moves the cursor one space to the right
@@ -177,16 +381,27 @@ void LCD_moveCursorLeft(struct LCD *this)
 void LCD_autoscroll(struct LCD *this)
 {
    this->displaymode |= LCD_ENTRYSHIFTINCREMENT;
-   LCD_command(this, LCD_ENTRYMODESET | this->displaymode);
+   modeChanged(this);
 }
 
 // This will 'left justify' text from the cursor
 void LCD_noAutoscroll(struct LCD *this)
 {
    this->displaymode &= ~LCD_ENTRYSHIFTINCREMENT;
-   LCD_command(this, LCD_ENTRYMODESET | this->displaymode);
+   modeChanged(this);
 }
 
+// Extra wait of the CGRAM accesses, the learned profile already covers them
+#ifdef LCD_CALIBRATE
+#define cgramDelay(this)
+#else
+#define cgramDelay(this)                \
+    do {                                \
+        if (!LCD_isQueued(this))        \
+            __delay_us(CGRAM_EXTRA);    \
+    } while (0)
+#endif
+
 // Write to CGRAM of new characters
 void LCD_createChar(struct LCD *this, uint8_t location, uint8_t charmap[])
 {
@@ -195,12 +410,12 @@ void LCD_createChar(struct LCD *this, uint8_t location, uint8_t charmap[])
    location &= 0x7;            // we only have 8 locations 0-7
    
    LCD_command(this, LCD_SETCGRAMADDR | (location << 3));
-   __delay_us(40);
+   cgramDelay(this);
    
    for (i=0; i<8; i++)
    {
       LCD_write(this, charmap[i]);      // call the virtual write method
-      __delay_us(40);
+      cgramDelay(this);
    }
 }
 
@@ -229,7 +444,8 @@ void LCD_printString(struct LCD *this, const char *value)
     }
 }
 
-static inline int8_t parseInt(uint16_t value)
+// The digits are kept in a buffer of the caller, so printing is reentrant
+static inline int8_t parseInt(uint8_t digit[], uint16_t value)
 {
     int8_t pos = 0;
 
@@ -242,7 +458,7 @@ static inline int8_t parseInt(uint16_t value)
     return pos-1;
 }
 
-static inline void writeDigits(struct LCD *this, int lastIndex)
+static inline void writeDigits(struct LCD *this, const uint8_t digit[], int lastIndex)
 {
     int8_t i = lastIndex;
 
@@ -255,16 +471,18 @@ static inline void writeDigits(struct LCD *this, int lastIndex)
 // Write an unsigned integer value to the LCD
 void LCD_printUInt(struct LCD *this, uint16_t value)
 {
+    uint8_t digit[6];
     int8_t lastIndex;
     
-    lastIndex = parseInt(value);
+    lastIndex = parseInt(digit, value);
 
-    writeDigits(this, lastIndex);
+    writeDigits(this, digit, lastIndex);
 }
 
 // Write a signed integer value to the LCD
 void LCD_printSInt(struct LCD *this, int16_t value)
 {
+    uint8_t digit[6];
     uint8_t sign, lastIndex;
 
     sign = (value & (1 << 15)) != 0;
@@ -273,12 +491,56 @@ void LCD_printSInt(struct LCD *this, int16_t value)
     if (sign == 1)
         value = ~value + 1;
 
-    lastIndex = parseInt(value);
+    lastIndex = parseInt(digit, value);
 
     if (sign) {
         ++lastIndex;
         digit[lastIndex] = '-';
     }
 
-    writeDigits(this, lastIndex);
+    writeDigits(this, digit, lastIndex);
+}
+
+// Estimate the worst case time of an operation
+uint16_t LCD_estimateCostUs(struct LCD *this, uint8_t op, uint8_t len)
+{
+#ifdef LCD_CALIBRATE
+    uint16_t data = this->costs->xfer + this->timing.write;
+    uint16_t command = this->costs->xfer + this->timing.address;
+    uint16_t cgram = this->costs->xfer + this->timing.cgram;
+    uint16_t homeClear = this->timing.homeClear;
+    uint16_t extra = 0;             // the learned times cover the CGRAM accesses
+#else
+    uint16_t data = this->costs->xfer + this->costs->exec;
+    uint16_t command = data;
+    uint16_t cgram = data;
+    uint16_t homeClear = this->costs->homeClear;
+    uint16_t extra = CGRAM_EXTRA;   // see LCD_createChar
+#endif
+
+    uint32_t total;
+
+    switch (op) {
+        case LCD_OP_WRITE:
+            // A long write on a slow interface doesn't fit in 16 bits
+            total = (uint32_t)data * len;
+            return (total > 0xFFFF) ? 0xFFFF : (uint16_t)total;
+
+        case LCD_OP_CLEAR:
+        case LCD_OP_HOME:
+            return this->costs->xfer + homeClear;
+
+        case LCD_OP_CREATECHAR:
+            // The address command and the 8 rows
+            return command + extra + 8 * (cgram + extra);
+
+        case LCD_OP_PRINTUINT:
+            return 5 * data;
+
+        case LCD_OP_PRINTSINT:
+            return 6 * data;
+
+        default:
+            return command;
+    }
 }
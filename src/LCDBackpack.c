@@ -0,0 +1,458 @@
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// Serial display backpack speaking the Matrix Orbital command set.
+#include <stdio.h>
+#include "LCDBackpack.h"
+
+// Parser states, other values of cmd are a command waiting for its arguments
+#define CMD_NONE        0
+#define CMD_PREFIX      LCD_BACKPACK_PREFIX
+
+// Arguments of the commands, the ones not listed take none
+static uint8_t argCount(uint8_t cmd)
+{
+    switch (cmd) {
+        case 'G':
+            return 2;
+
+        case 'N':
+            return 9;
+
+        case 'B':               // Backlight on, minutes
+        case 'P':               // Contrast
+        case 'V':               // GPO on
+        case 'W':               // GPO off
+        case 0x91:              // Contrast, saved
+        case 0x98:              // Brightness, saved
+        case 0x99:              // Brightness
+            return 1;
+
+        default:
+            return 0;
+    }
+}
+
+static uint8_t *rowText(struct LCDBackpack *bp, uint8_t row)
+{
+    return &bp->screen[row * bp->lcd->cols];
+}
+
+static void markSpan(struct LCDBackpack *bp, uint8_t row, uint8_t c0, uint8_t c1)
+{
+    if (c0 < bp->dmin[row])
+        bp->dmin[row] = c0;
+    if (c1 > bp->dmax[row])
+        bp->dmax[row] = c1;
+}
+
+static void clearSpans(struct LCDBackpack *bp)
+{
+    uint8_t row;
+
+    for (row = 0; row < LCD_BACKPACK_MAXROWS; row++) {
+        bp->dmin[row] = 0xFF;
+        bp->dmax[row] = 0;
+    }
+}
+
+static void setChar(struct LCDBackpack *bp, uint8_t row, uint8_t col, uint8_t c)
+{
+    uint8_t *p = rowText(bp, row) + col;
+
+    if (*p != c) {
+        *p = c;
+        markSpan(bp, row, col, col);
+    }
+}
+
+// Move the text up one line. Cells keep their pending marks, so a cell is
+// only marked again when its text changes.
+static void scrollUp(struct LCDBackpack *bp)
+{
+    uint8_t last = bp->lcd->numlines - 1;
+    uint8_t row, col;
+    const uint8_t *next;
+
+    for (row = 0; row <= last; row++) {
+        next = (row < last) ? rowText(bp, row + 1) : NULL;
+        for (col = 0; col < bp->lcd->cols; col++)
+            setChar(bp, row, col, (next != NULL) ? next[col] : ' ');
+    }
+}
+
+static void newLine(struct LCDBackpack *bp)
+{
+    bp->col = 0;
+    if (bp->row + 1 < bp->lcd->numlines)
+        bp->row++;
+    else if (bp->scroll)
+        scrollUp(bp);
+    else
+        bp->row = 0;
+}
+
+static void clearScreen(struct LCDBackpack *bp)
+{
+    uint8_t row, col;
+
+    for (row = 0; row < bp->lcd->numlines; row++) {
+        for (col = 0; col < bp->lcd->cols; col++)
+            setChar(bp, row, col, ' ');
+    }
+
+    bp->cleared = true;
+    bp->col = 0;
+    bp->row = 0;
+}
+
+static void text(struct LCDBackpack *bp, uint8_t c)
+{
+    switch (c) {
+        case '\r':
+            bp->col = 0;
+            break;
+
+        case '\n':
+            newLine(bp);
+            break;
+
+        case '\b':
+            if (bp->col > 0)
+                bp->col--;
+            break;
+
+        default:
+            // Codes 0 to 7 are the custom characters, other controls are ignored
+            if (c < 0x20 && c > 7)
+                break;
+
+            if (bp->col >= bp->lcd->cols) {
+                if (!bp->wrap)
+                    break;
+                newLine(bp);
+            }
+
+            setChar(bp, bp->row, bp->col, c);
+            bp->col++;
+            break;
+    }
+}
+
+static void defineGlyph(struct LCDBackpack *bp)
+{
+    uint8_t n = bp->args[0];
+    uint8_t bit, i;
+    bool same;
+
+    if (n > 7)
+        return;
+
+    bit = 1 << n;
+    same = (bp->glyphValid & bit) != 0;
+    for (i = 0; i < 8; i++) {
+        if (bp->glyphs[n][i] != bp->args[1 + i]) {
+            bp->glyphs[n][i] = bp->args[1 + i];
+            same = false;
+        }
+    }
+
+    // A glyph redefined with the same rows is not uploaded again
+    if (!same)
+        bp->glyphDirty |= bit;
+    bp->glyphValid |= bit;
+}
+
+static void command(struct LCDBackpack *bp)
+{
+    uint8_t lastCol = bp->lcd->cols - 1;
+    uint8_t lastRow = bp->lcd->numlines - 1;
+
+    switch (bp->cmd) {
+        case 'X':
+            clearScreen(bp);
+            break;
+
+        case 'H':
+            bp->col = 0;
+            bp->row = 0;
+            break;
+
+        case 'G':
+            bp->col = (bp->args[0] > 1) ? bp->args[0] - 1 : 0;
+            bp->row = (bp->args[1] > 1) ? bp->args[1] - 1 : 0;
+            if (bp->col > lastCol)
+                bp->col = lastCol;
+            if (bp->row > lastRow)
+                bp->row = lastRow;
+            break;
+
+        case 'L':
+            if (bp->col > 0)
+                bp->col--;
+            break;
+
+        case 'M':
+            if (bp->col < lastCol)
+                bp->col++;
+            break;
+
+        case 'J':
+            bp->cursor |= LCD_CURSORON;
+            break;
+
+        case 'K':
+            bp->cursor &= ~LCD_CURSORON;
+            break;
+
+        case 'S':
+            bp->cursor |= LCD_BLINKON;
+            break;
+
+        case 'T':
+            bp->cursor &= ~LCD_BLINKON;
+            break;
+
+        case 'C':
+            bp->wrap = true;
+            break;
+
+        case 'D':
+            bp->wrap = false;
+            break;
+
+        case 'Q':
+            bp->scroll = true;
+            break;
+
+        case 'R':
+            bp->scroll = false;
+            break;
+
+        case 'N':
+            defineGlyph(bp);
+            break;
+
+        case 'B':
+        case 'F':
+            bp->light = (bp->cmd == 'B');
+            if (bp->backlight != NULL)
+                bp->backlight(bp->light);
+            break;
+
+        default:
+            break;
+    }
+}
+
+// Columns of a line that are not blank, false if the line is blank
+static bool usedSpan(struct LCDBackpack *bp, uint8_t row, uint8_t *first, uint8_t *last)
+{
+    const uint8_t *p = rowText(bp, row);
+    uint8_t col;
+    bool used = false;
+
+    for (col = 0; col < bp->lcd->cols; col++) {
+        if (p[col] != ' ') {
+            if (!used)
+                *first = col;
+            *last = col;
+            used = true;
+        }
+    }
+    return used;
+}
+
+// After a clear, clearing the LCD and writing the text left on the screen
+// can be faster than overwriting the changed cells with blanks.
+static void clearIfFaster(struct LCDBackpack *bp)
+{
+    uint8_t row, first, last;
+    uint8_t changed = 0;
+    uint8_t used = 0;
+
+    // One cursor command per line, it costs about one character
+    for (row = 0; row < bp->lcd->numlines; row++) {
+        if (bp->dmin[row] <= bp->dmax[row])
+            changed += bp->dmax[row] - bp->dmin[row] + 2;
+        if (usedSpan(bp, row, &first, &last))
+            used += last - first + 2;
+    }
+
+    if ((uint32_t)LCD_estimateCostUs(bp->lcd, LCD_OP_CLEAR, 0) + LCD_estimateCostUs(bp->lcd, LCD_OP_WRITE, used) >=
+        LCD_estimateCostUs(bp->lcd, LCD_OP_WRITE, changed))
+        return;
+
+    LCD_clear(bp->lcd);
+    clearSpans(bp);
+    for (row = 0; row < bp->lcd->numlines; row++) {
+        if (usedSpan(bp, row, &first, &last))
+            markSpan(bp, row, first, last);
+    }
+    bp->lcdCol = 0;
+    bp->lcdRow = 0;
+}
+
+// Cursor shape and display on/off
+static void updateControl(struct LCDBackpack *bp)
+{
+    struct LCD *lcd = bp->lcd;
+    uint8_t changed = (lcd->displaycontrol ^ bp->cursor) & (LCD_CURSORON | LCD_BLINKON);
+
+    if (changed & LCD_CURSORON) {
+        if (bp->cursor & LCD_CURSORON)
+            LCD_cursor(lcd);
+        else
+            LCD_noCursor(lcd);
+    }
+
+    if (changed & LCD_BLINKON) {
+        if (bp->cursor & LCD_BLINKON)
+            LCD_blink(lcd);
+        else
+            LCD_noBlink(lcd);
+    }
+
+    // Without backlight control the backlight commands turn the display on and off
+    if (bp->backlight == NULL && bp->light != ((lcd->displaycontrol & LCD_DISPLAYON) != 0)) {
+        if (bp->light)
+            LCD_display(lcd);
+        else
+            LCD_noDisplay(lcd);
+    }
+}
+
+void LCD_initBackpack(struct LCDBackpack *bp, struct LCD *lcd, uint8_t *screen, uint8_t *rx, uint8_t rxSize,
+                      void (*backlight)(bool on))
+{
+    uint8_t i;
+
+    bp->lcd = lcd;
+    bp->screen = screen;
+    bp->rx = rx;
+    bp->rxSize = rxSize;
+    bp->rxHead = 0;
+    bp->rxTail = 0;
+    bp->backlight = backlight;
+
+    for (i = 0; i < lcd->numlines * lcd->cols; i++)
+        screen[i] = ' ';
+
+    clearSpans(bp);
+    bp->col = 0;
+    bp->row = 0;
+    bp->cleared = false;
+    bp->wrap = true;
+    bp->scroll = false;
+    bp->cursor = 0;
+    bp->light = true;
+    bp->glyphValid = 0;
+    bp->glyphDirty = 0;
+    bp->cmd = CMD_NONE;
+
+    LCD_clear(lcd);
+    LCD_noCursor(lcd);
+    LCD_noBlink(lcd);
+    LCD_display(lcd);
+    if (backlight != NULL)
+        backlight(true);
+
+    bp->lcdCol = 0;
+    bp->lcdRow = 0;
+}
+
+void LCD_backpackPut(struct LCDBackpack *bp, uint8_t byte)
+{
+    switch (bp->cmd) {
+        case CMD_NONE:
+            if (byte == LCD_BACKPACK_PREFIX)
+                bp->cmd = CMD_PREFIX;
+            else
+                text(bp, byte);
+            return;
+
+        case CMD_PREFIX:
+            bp->cmd = byte;
+            bp->nargs = argCount(byte);
+            bp->got = 0;
+            break;
+
+        default:
+            bp->args[bp->got++] = byte;
+            break;
+    }
+
+    if (bp->got == bp->nargs) {
+        command(bp);
+        bp->cmd = CMD_NONE;
+    }
+}
+
+// Send the changed characters, the cursor command is skipped when the LCD
+// address is already where the change starts.
+void LCD_backpackFlush(struct LCDBackpack *bp)
+{
+    struct LCD *lcd = bp->lcd;
+    const uint8_t *p;
+    uint8_t row, col, i;
+
+    // Glyphs first, the new text shows them right away
+    for (i = 0; i < 8; i++) {
+        if (bp->glyphDirty & (1 << i)) {
+            LCD_createChar(lcd, i, bp->glyphs[i]);
+            bp->lcdRow = 0xFF;
+        }
+    }
+    bp->glyphDirty = 0;
+
+    if (bp->cleared) {
+        clearIfFaster(bp);
+        bp->cleared = false;
+    }
+
+    for (row = 0; row < lcd->numlines; row++) {
+        if (bp->dmin[row] > bp->dmax[row])
+            continue;
+
+        if (bp->lcdRow != row || bp->lcdCol != bp->dmin[row])
+            LCD_setCursor(lcd, bp->dmin[row], row);
+
+        p = rowText(bp, row);
+        for (col = bp->dmin[row]; col <= bp->dmax[row]; col++)
+            LCD_write(lcd, p[col]);
+
+        bp->lcdRow = row;
+        bp->lcdCol = col;
+        bp->dmin[row] = 0xFF;
+        bp->dmax[row] = 0;
+    }
+
+    updateControl(bp);
+
+    // A visible cursor has to be where the host put it
+    if (bp->cursor != 0) {
+        col = (bp->col < lcd->cols) ? bp->col : lcd->cols - 1;
+        if (bp->lcdRow != bp->row || bp->lcdCol != col) {
+            LCD_setCursor(lcd, col, bp->row);
+            bp->lcdRow = bp->row;
+            bp->lcdCol = col;
+        }
+    }
+
+    LCD_flushModes(lcd);
+}
+
+void LCD_backpackPoll(struct LCDBackpack *bp)
+{
+    uint8_t tail = bp->rxTail;
+
+    // Free each byte right away, the interrupt may be refilling the ring
+    while (tail != bp->rxHead) {
+        LCD_backpackPut(bp, bp->rx[tail]);
+        if (++tail == bp->rxSize)
+            tail = 0;
+        bp->rxTail = tail;
+    }
+
+    LCD_backpackFlush(bp);
+}
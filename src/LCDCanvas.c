@@ -0,0 +1,161 @@
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// Small pixel canvas made of the CGRAM glyphs.
+#include <stdio.h>
+#include "LCDCanvas.h"
+
+void LCD_initCanvas(struct LCD *this, struct LCDCanvas *c, uint8_t col, uint8_t row, uint8_t cols, uint8_t rows, uint8_t first)
+{
+    uint8_t i, j;
+
+    // Keep the tiles within the 8 glyphs, bits and dirty have room for 8
+    first &= 0x07;
+    if (cols > 8 - first)
+        cols = 8 - first;
+    if (cols != 0 && rows > (8 - first) / cols)
+        rows = (8 - first) / cols;
+
+    c->col = col;
+    c->row = row;
+    c->cols = cols;
+    c->rows = rows;
+    c->first = first;
+
+    // Upload everything on the first flush
+    for (i = 0; i < 64; i++)
+        c->bits[i] = 0;
+    for (i = 0; i < 8; i++)
+        c->dirty[i] = 0xFF;
+
+    // The cells showing the tiles are written once
+    for (j = 0; j < rows; j++) {
+        LCD_setCursor(this, col, row + j);
+        for (i = 0; i < cols; i++)
+            LCD_write(this, first + j * cols + i);
+    }
+
+    LCD_canvasFlush(this, c);
+}
+
+void LCD_canvasClear(struct LCDCanvas *c)
+{
+    uint8_t i;
+
+    for (i = 0; i < 64; i++) {
+        if (c->bits[i] != 0) {
+            c->bits[i] = 0;
+            c->dirty[i >> 3] |= 1 << (i & 7);
+        }
+    }
+}
+
+void LCD_canvasPixel(struct LCDCanvas *c, uint8_t x, uint8_t y, bool on)
+{
+    uint8_t tile, mask, old;
+    uint8_t *p;
+
+    if (x >= LCD_canvasWidth(c) || y >= LCD_canvasHeight(c))
+        return;
+
+    tile = (y >> 3) * c->cols + x / 5;
+    mask = 0x10 >> (x % 5);
+    p = &c->bits[(tile << 3) + (y & 7)];
+
+    old = *p;
+    if (on)
+        *p |= mask;
+    else
+        *p &= ~mask;
+
+    if (*p != old)
+        c->dirty[tile] |= 1 << (y & 7);
+}
+
+// Bresenham
+void LCD_canvasLine(struct LCDCanvas *c, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, bool on)
+{
+    int8_t dx = (x1 > x0) ? x1 - x0 : x0 - x1;
+    int8_t dy = (y1 > y0) ? y0 - y1 : y1 - y0;
+    int8_t sx = (x0 < x1) ? 1 : -1;
+    int8_t sy = (y0 < y1) ? 1 : -1;
+    int8_t err = dx + dy;
+    int8_t e2;
+
+    for (;;) {
+        LCD_canvasPixel(c, x0, y0, on);
+        if (x0 == x1 && y0 == y1)
+            break;
+        e2 = 2 * err;
+        if (e2 >= dy) {
+            err += dy;
+            x0 += sx;
+        }
+        if (e2 <= dx) {
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+void LCD_canvasSparkline(struct LCDCanvas *c, const int16_t *values, uint8_t n, int16_t lo, int16_t hi)
+{
+    uint8_t width = LCD_canvasWidth(c);
+    uint8_t top = LCD_canvasHeight(c) - 1;
+    uint8_t x, y, prev = 0;
+    int32_t v, range;
+
+    LCD_canvasClear(c);
+
+    // In 32 bits, hi - lo overflows an int of 16 bits
+    range = (int32_t)hi - lo;
+    if (range <= 0) {
+        hi = lo;
+        range = 1;
+    }
+
+    for (x = 0; x < n && x < width; x++) {
+        v = values[x];
+        if (v < lo)
+            v = lo;
+        else if (v > hi)
+            v = hi;
+
+        y = top - (uint8_t)(((v - lo) * top + range / 2) / range);
+
+        if (x == 0)
+            LCD_canvasPixel(c, x, y, true);
+        else
+            LCD_canvasLine(c, x - 1, prev, x, y, true);
+        prev = y;
+    }
+}
+
+void LCD_canvasFlush(struct LCD *this, struct LCDCanvas *c)
+{
+    uint8_t tiles = c->cols * c->rows;
+    uint8_t tile, first, last, dirty;
+    const uint8_t *p;
+
+    for (tile = 0; tile < tiles; tile++) {
+        dirty = c->dirty[tile];
+        if (dirty == 0)
+            continue;
+
+        // One address for the span of rows that changed
+        for (first = 0; !(dirty & (1 << first)); first++)
+            ;
+        for (last = 7; !(dirty & (1 << last)); last--)
+            ;
+
+        LCD_command(this, LCD_SETCGRAMADDR | (((c->first + tile) & 0x07) << 3) | first);
+        p = &c->bits[(tile << 3) + first];
+        for (; first <= last; first++)
+            LCD_write(this, *p++);
+
+        c->dirty[tile] = 0;
+    }
+
+    // Writes go to DDRAM again
+    LCD_setCursor(this, c->col, c->row);
+}
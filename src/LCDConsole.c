@@ -0,0 +1,334 @@
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// Scrolling text console for the PIC LCD library.
+#include <stdio.h>
+#include "LCDConsole.h"
+
+#define ESC         0x1B
+
+// Escape sequence parser states
+#define ESC_NONE    0
+#define ESC_START   1
+#define ESC_CSI     2
+
+#ifdef LCD_CONSOLE_PUTCH
+struct LCDConsole *LCD_stdout;
+
+void putch(char c)
+{
+    if (LCD_stdout != NULL)
+        LCD_consolePutch(LCD_stdout, c);
+}
+#endif
+
+// Text of a line of the LCD
+static char *rowText(struct LCDConsole *con, uint8_t row)
+{
+    row += con->top;
+    if (row >= con->lcd->numlines)
+        row -= con->lcd->numlines;
+
+    return &con->buf[row * con->lcd->cols];
+}
+
+static void markSpan(struct LCDConsole *con, uint8_t row, uint8_t c0, uint8_t c1)
+{
+    if (c0 < con->dmin[row])
+        con->dmin[row] = c0;
+    if (c1 > con->dmax[row])
+        con->dmax[row] = c1;
+}
+
+static void clearSpans(struct LCDConsole *con)
+{
+    uint8_t row;
+
+    for (row = 0; row < LCD_CONSOLE_MAXROWS; row++) {
+        con->dmin[row] = 0xFF;
+        con->dmax[row] = 0;
+    }
+}
+
+static void setChar(struct LCDConsole *con, uint8_t row, uint8_t col, char c)
+{
+    char *p = rowText(con, row) + col;
+
+    if (*p != c) {
+        *p = c;
+        markSpan(con, row, col, col);
+    }
+}
+
+static void clearRange(struct LCDConsole *con, uint8_t row, uint8_t c0, uint8_t c1)
+{
+    for (; c0 <= c1; c0++)
+        setChar(con, row, c0, ' ');
+}
+
+// Send the changed characters, the cursor command is skipped when the LCD
+// address is already where the change starts.
+static void flush(struct LCDConsole *con)
+{
+    const char *p;
+    uint8_t row, col;
+
+    for (row = 0; row < con->lcd->numlines; row++) {
+        if (con->dmin[row] > con->dmax[row])
+            continue;
+
+        if (con->lcdRow != row || con->lcdCol != con->dmin[row])
+            LCD_setCursor(con->lcd, con->dmin[row], row);
+
+        p = rowText(con, row);
+        for (col = con->dmin[row]; col <= con->dmax[row]; col++)
+            LCD_write(con->lcd, (uint8_t)p[col]);
+
+        con->lcdRow = row;
+        con->lcdCol = col;
+        con->dmin[row] = 0xFF;
+        con->dmax[row] = 0;
+    }
+}
+
+// Move the text up one line, each line of the LCD is compared with the one
+// that will replace it so only the differences are sent.
+static void scroll(struct LCDConsole *con)
+{
+    char *cur;
+    const char *next;
+    uint8_t row, col, last;
+
+    flush(con);
+
+    last = con->lcd->numlines - 1;
+    for (row = 0; row <= last; row++) {
+        cur = rowText(con, row);
+        next = (row < last) ? rowText(con, row + 1) : NULL;
+
+        for (col = 0; col < con->lcd->cols; col++) {
+            if (cur[col] != (next != NULL ? next[col] : ' '))
+                markSpan(con, row, col, col);
+        }
+    }
+
+    // The first line is recycled as the new last line
+    cur = rowText(con, 0);
+    con->top = (con->top < last) ? con->top + 1 : 0;
+    for (col = 0; col < con->lcd->cols; col++)
+        cur[col] = ' ';
+}
+
+static void newLine(struct LCDConsole *con)
+{
+    con->col = 0;
+    if (con->row + 1 < con->lcd->numlines)
+        con->row++;
+    else
+        scroll(con);
+}
+
+static void clearScreen(struct LCDConsole *con)
+{
+    uint8_t row, col, used;
+    char *p;
+
+    used = 0;
+    for (row = 0; row < con->lcd->numlines; row++) {
+        p = rowText(con, row);
+        for (col = 0; col < con->lcd->cols; col++) {
+            if (p[col] != ' ')
+                used++;
+        }
+    }
+
+    // Overwriting just the used cells can be faster than a clear
+    if (LCD_estimateCostUs(con->lcd, LCD_OP_WRITE, used) > LCD_estimateCostUs(con->lcd, LCD_OP_CLEAR, 0)) {
+        LCD_clear(con->lcd);
+        for (row = 0; row < con->lcd->numlines; row++) {
+            p = rowText(con, row);
+            for (col = 0; col < con->lcd->cols; col++)
+                p[col] = ' ';
+        }
+        clearSpans(con);
+        con->lcdRow = 0;
+        con->lcdCol = 0;
+    } else {
+        for (row = 0; row < con->lcd->numlines; row++)
+            clearRange(con, row, 0, con->lcd->cols - 1);
+    }
+}
+
+static void escape(struct LCDConsole *con, char c)
+{
+    uint8_t n = (con->param[0] != 0) ? con->param[0] : 1;
+    uint8_t lastCol = con->lcd->cols - 1;
+    uint8_t lastRow = con->lcd->numlines - 1;
+
+    if (con->col > lastCol)
+        con->col = lastCol;
+
+    switch (c) {
+        case 'H':
+        case 'f':
+            con->row = (con->param[0] != 0) ? con->param[0] - 1 : 0;
+            con->col = (con->param[1] != 0) ? con->param[1] - 1 : 0;
+            if (con->row > lastRow)
+                con->row = lastRow;
+            if (con->col > lastCol)
+                con->col = lastCol;
+            break;
+
+        case 'K':
+            if (con->param[0] == 0)
+                clearRange(con, con->row, con->col, lastCol);
+            else if (con->param[0] == 1)
+                clearRange(con, con->row, 0, con->col);
+            else
+                clearRange(con, con->row, 0, lastCol);
+            break;
+
+        case 'J':
+            if (con->param[0] == 2)
+                clearScreen(con);
+            break;
+
+        case 'A':
+            con->row = (n < con->row) ? con->row - n : 0;
+            break;
+
+        case 'B':
+            con->row = (n < lastRow - con->row) ? con->row + n : lastRow;
+            break;
+
+        case 'C':
+            con->col = (n < lastCol - con->col) ? con->col + n : lastCol;
+            break;
+
+        case 'D':
+            con->col = (n < con->col) ? con->col - n : 0;
+            break;
+
+        default:
+            break;
+    }
+}
+
+// Returns true when the character is part of an escape sequence
+static bool parseEscape(struct LCDConsole *con, char c)
+{
+    switch (con->esc) {
+        case ESC_START:
+            con->esc = (c == '[') ? ESC_CSI : ESC_NONE;
+            con->nparam = 0;
+            con->param[0] = 0;
+            con->param[1] = 0;
+            return true;
+
+        case ESC_CSI:
+            if (c >= '0' && c <= '9') {
+                if (con->param[con->nparam] < 25)
+                    con->param[con->nparam] = con->param[con->nparam] * 10 + (c - '0');
+            } else if (c == ';') {
+                if (con->nparam < 1)
+                    con->nparam++;
+            } else {
+                escape(con, c);
+                con->esc = ESC_NONE;
+            }
+            return true;
+
+        default:
+            if (c == ESC) {
+                con->esc = ESC_START;
+                return true;
+            }
+            return false;
+    }
+}
+
+void LCD_initConsole(struct LCDConsole *con, struct LCD *lcd, char *buf)
+{
+    uint8_t i;
+
+    con->lcd = lcd;
+    con->buf = buf;
+
+    for (i = 0; i < lcd->numlines * lcd->cols; i++)
+        buf[i] = ' ';
+
+    con->top = 0;
+    con->col = 0;
+    con->row = 0;
+    con->esc = ESC_NONE;
+    clearSpans(con);
+
+    LCD_clear(lcd);
+    con->lcdCol = 0;
+    con->lcdRow = 0;
+}
+
+void LCD_consolePutch(struct LCDConsole *con, char c)
+{
+    if (parseEscape(con, c))
+    {
+        flush(con);
+        return;
+    }
+
+    switch (c) {
+        case '\n':
+            newLine(con);
+            break;
+
+        case '\r':
+            con->col = 0;
+            break;
+
+        case '\b':
+            if (con->col >= con->lcd->cols)
+                con->col = con->lcd->cols - 1;
+            else if (con->col > 0)
+                con->col--;
+            break;
+
+        case '\f':
+            clearScreen(con);
+            con->col = 0;
+            con->row = 0;
+            break;
+
+        default:
+            // Codes 1 to 7 are the custom characters, other controls are ignored
+            if ((uint8_t)c < 0x20 && (c == 0 || c > 7))
+                break;
+
+            if (con->col >= con->lcd->cols)
+                newLine(con);
+
+            setChar(con, con->row, con->col, c);
+            con->col++;
+            break;
+    }
+
+    flush(con);
+}
+
+void LCD_consolePrint(struct LCDConsole *con, const char *s)
+{
+    while (*s != '\0') {
+        LCD_consolePutch(con, *s);
+        s++;
+    }
+}
+
+void LCD_consoleRedraw(struct LCDConsole *con)
+{
+    uint8_t row;
+
+    for (row = 0; row < con->lcd->numlines; row++)
+        markSpan(con, row, 0, con->lcd->cols - 1);
+
+    con->lcdRow = 0xFF;
+    flush(con);
+}
@@ -0,0 +1,108 @@
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// 4x4 keypad sharing the D4-D7 lines of a parallel LCD.
+#include <stdio.h>
+#include "LCDKeypad.h"
+
+// Drive one row low and read the columns, the port is restored afterwards
+static void scanRow(struct LCDKeypad *kp, uint8_t row)
+{
+    uint8_t rowMask = 0x0F << kp->rowShift;
+    uint8_t lat = *(kp->dport);
+    uint8_t tris = *(kp->dtris);
+    uint8_t shift = row << 2;
+    uint16_t mask = (uint16_t)0x0F << shift;
+    uint16_t now, stable, keys;
+
+    *(kp->dport) = lat & ~rowMask;
+    LCD_portChanged(kp->dport);
+    *(kp->dtris) = (tris | rowMask) & ~(1 << (kp->rowShift + row));
+    LCD_portChanged(kp->dtris);
+
+    waitUsec(1);    // let the column pull-ups settle
+    now = (uint16_t)(~(*(kp->cols) >> kp->colShift) & 0x0F) << shift;
+
+    *(kp->dtris) = tris;
+    LCD_portChanged(kp->dtris);
+    *(kp->dport) = lat;
+    LCD_portChanged(kp->dport);
+
+    // Keys change when two scans agree
+    stable = ~(now ^ kp->raw) & mask;
+    keys = (kp->keys & ~stable) | (now & stable);
+    kp->pressed |= keys & ~kp->keys;
+    kp->keys = keys;
+    kp->raw = (kp->raw & ~mask) | now;
+}
+
+static void keypadSend(struct LCDHook *hook, struct LCD *lcd, uint8_t value, uint8_t mode)
+{
+    struct LCDKeypad *kp = (struct LCDKeypad *)hook;
+    uint8_t tris = *(kp->dtris);
+    uint8_t lat = *(kp->dport);
+
+    // The LCD needs its data lines as outputs
+    *(kp->dtris) = tris & ~kp->dataMask;
+    LCD_portChanged(kp->dtris);
+
+    LCD_hookForward(hook, lcd, value, mode);
+
+    // E is low and the LCD is executing the byte
+    scanRow(kp, kp->next);
+    kp->next = (kp->next + 1) & 0x03;
+
+    // The application's latch of the data lines, the LCD overwrote it
+    *(kp->dport) = (*(kp->dport) & ~kp->dataMask) | (lat & kp->dataMask);
+    LCD_portChanged(kp->dport);
+    *(kp->dtris) = tris;
+    LCD_portChanged(kp->dtris);
+}
+
+bool LCD_initKeypad(struct LCDKeypad *kp, struct LCD *lcd, volatile uint8_t *dtris, volatile uint8_t *cols, uint8_t colShift)
+{
+    // The data port is only known to the parallel driver
+    if (lcd->begin != &LCD_beginParallel)
+        return false;
+
+    kp->dport = lcd->i.pi.lcd_dport;
+    kp->dtris = dtris;
+    kp->cols = cols;
+    kp->colShift = colShift;
+    kp->next = 0;
+    kp->raw = 0;
+    kp->keys = 0;
+    kp->pressed = 0;
+
+    if (lcd->displayfunction & LCD_8BITMODE) {
+        kp->dataMask = 0xFF;
+        kp->rowShift = 4;
+    } else {
+#ifndef LCD_USE_UPPER_NIBBLE
+        kp->dataMask = 0x0F;
+        kp->rowShift = 0;
+#else
+        kp->dataMask = 0xF0;
+        kp->rowShift = 4;
+#endif
+    }
+
+    LCD_addHook(lcd, &kp->hook, &keypadSend);
+    return true;
+}
+
+void LCD_keypadScan(struct LCDKeypad *kp)
+{
+    uint8_t row;
+
+    for (row = 0; row < 4; row++)
+        scanRow(kp, row);
+}
+
+uint16_t LCD_keypadPressed(struct LCDKeypad *kp)
+{
+    uint16_t pressed = kp->pressed;
+
+    kp->pressed = 0;
+    return pressed;
+}
@@ -0,0 +1,120 @@
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// Virtualized list view for menus with many entries.
+#include <stdio.h>
+#include "LCDList.h"
+
+static uint8_t listWidth(struct LCD *this)
+{
+    return (this->cols < LCD_LIST_COLS) ? this->cols : LCD_LIST_COLS;
+}
+
+// Build the cells of a row: the marker and the item text padded with blanks
+static void buildRow(struct LCDList *list, uint8_t width, uint16_t index, bool marked, char *line)
+{
+    uint8_t col = 1;
+
+    line[0] = marked ? LCD_LIST_MARKER : ' ';
+
+    if (index != LCD_LIST_NONE) {
+        line[width] = '\0';
+        list->itemText(index, &line[1], width - 1);
+        while (col < width && line[col] != '\0')
+            col++;
+    }
+
+    for (; col < width; col++)
+        line[col] = ' ';
+}
+
+static void drawRow(struct LCD *this, struct LCDList *list, uint8_t r, bool force)
+{
+    char oldLine[LCD_LIST_COLS + 1];
+    char newLine[LCD_LIST_COLS + 1];
+    uint8_t width = listWidth(this);
+    uint16_t index = list->top + r;
+    bool wasMarked = (r == list->markerRow);
+    bool marked;
+    uint8_t col, cursor;
+
+    // Rows past the end show no item and never the marker
+    if (index >= list->count)
+        index = LCD_LIST_NONE;
+    marked = (index != LCD_LIST_NONE && index == list->selected);
+
+    if (!force && index == list->shown[r]) {
+        // Same item, at most the marker changed
+        if (marked != wasMarked) {
+            LCD_setCursor(this, 0, list->row + r);
+            LCD_write(this, marked ? LCD_LIST_MARKER : ' ');
+        }
+        return;
+    }
+
+    buildRow(list, width, index, marked, newLine);
+    if (!force)
+        buildRow(list, width, list->shown[r], wasMarked, oldLine);
+
+    // Send only the cells that differ
+    cursor = 0xFF;
+    for (col = 0; col < width; col++) {
+        if (!force && oldLine[col] == newLine[col])
+            continue;
+        if (cursor != col)
+            LCD_setCursor(this, col, list->row + r);
+        LCD_write(this, (uint8_t)newLine[col]);
+        cursor = col + 1;
+    }
+}
+
+static void drawRows(struct LCD *this, struct LCDList *list, bool force)
+{
+    uint8_t r;
+
+    for (r = 0; r < list->rows; r++)
+        drawRow(this, list, r, force);
+
+    for (r = 0; r < list->rows; r++)
+        list->shown[r] = (list->top + r < list->count) ? list->top + r : LCD_LIST_NONE;
+    list->markerRow = (list->selected < list->count) ? list->selected - list->top : 0xFF;
+}
+
+void LCD_initList(struct LCD *this, struct LCDList *list, uint8_t row, uint8_t rows, uint16_t count, void (*itemText)(uint16_t index, char *text, uint8_t width))
+{
+    list->itemText = itemText;
+    list->count = count;
+    list->top = 0;
+    list->selected = 0;
+    list->row = row;
+    list->rows = (rows < LCD_LIST_ROWS) ? rows : LCD_LIST_ROWS;
+
+    LCD_listRedraw(this, list);
+}
+
+void LCD_listSelect(struct LCD *this, struct LCDList *list, uint16_t index)
+{
+    if (list->count == 0)
+        return;
+
+    if (index >= list->count)
+        index = list->count - 1;
+
+    if (index < list->top)
+        list->top = index;
+    else if (index >= list->top + list->rows)
+        list->top = index - list->rows + 1;
+
+    list->selected = index;
+    LCD_listUpdate(this, list);
+}
+
+void LCD_listUpdate(struct LCD *this, struct LCDList *list)
+{
+    drawRows(this, list, false);
+}
+
+void LCD_listRedraw(struct LCD *this, struct LCDList *list)
+{
+    drawRows(this, list, true);
+}
@@ -0,0 +1,192 @@
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// Mirrors the display as a compact delta stream, e.g. over a UART.
+#include <stdio.h>
+#include "LCDMirror.h"
+
+static void emit(struct LCDMirror *m, uint8_t value)
+{
+    m->sink(value);
+    m->sinceKeyframe++;
+}
+
+// DDRAM length of a line, 40 cells on LCDs of more than one line
+static uint8_t lineLength(struct LCD *lcd)
+{
+    return (lcd->displayfunction & LCD_2LINE) ? LCD_MIRROR_DDRAM_SIZE / 2 : LCD_MIRROR_DDRAM_SIZE;
+}
+
+// Position of a DDRAM address in the shadow, 0xFF if the LCD has no such address
+static uint8_t shadowIndex(struct LCD *lcd, uint8_t addr)
+{
+    uint8_t pos = addr & 0x3F;
+
+    if (!(lcd->displayfunction & LCD_2LINE))
+        return (addr < LCD_MIRROR_DDRAM_SIZE) ? addr : 0xFF;
+    if (pos >= LCD_MIRROR_DDRAM_SIZE / 2)
+        return 0xFF;
+    return (addr & 0x40) ? LCD_MIRROR_DDRAM_SIZE / 2 + pos : pos;
+}
+
+static void moveDisplay(struct LCDMirror *m, struct LCD *lcd, bool right)
+{
+    uint8_t len = lineLength(lcd);
+
+    if (right)
+        m->shift = (m->shift + 1 == len) ? 0 : m->shift + 1;
+    else
+        m->shift = (m->shift == 0) ? len - 1 : m->shift - 1;
+}
+
+static void clearShadow(struct LCDMirror *m)
+{
+    uint8_t i;
+
+    for (i = 0; i < LCD_MIRROR_DDRAM_SIZE; i++)
+        m->shadow[i] = ' ';
+    m->shift = 0;
+}
+
+// A pending DDRAM run is already in the shadow, a CGRAM run may be nowhere
+// else and is sent
+static void discardRun(struct LCDMirror *m)
+{
+    if (m->runCgram)
+        LCD_mirrorFlush(m);
+    else
+        m->runLen = 0;
+}
+
+static void mirrorSend(struct LCDHook *hook, struct LCD *lcd, uint8_t value, uint8_t mode)
+{
+    struct LCDMirror *m = (struct LCDMirror *)hook;
+    uint8_t addr = m->track.addr;
+    bool cgram = m->track.cgram;
+    uint8_t i;
+
+    LCD_hookForward(hook, lcd, value, mode);
+    LCD_track(&m->track, lcd, value, mode);
+
+    if (mode == DATA) {
+        if (cgram) {
+            if (m->cgram != NULL)
+                m->cgram[addr] = value;
+        } else {
+            i = shadowIndex(lcd, addr);
+            if (i == 0xFF)
+                return;     // No such address on the LCD
+            m->shadow[i] = value;
+
+            // Autoscroll, the display moves against the cursor
+            if (m->track.entry & LCD_ENTRYSHIFTINCREMENT)
+                moveDisplay(m, lcd, !(m->track.entry & LCD_ENTRYLEFT));
+        }
+
+        // Continue the run if the write is right after it
+        if (m->runLen != 0 &&
+            (m->runCgram != cgram || m->runAddr + m->runLen != addr || m->runLen == LCD_MIRROR_RUN))
+            LCD_mirrorFlush(m);
+
+        if (m->runLen == 0) {
+            m->runAddr = addr;
+            m->runCgram = cgram;
+        }
+        m->run[m->runLen++] = value;
+    } else if (value & (LCD_SETDDRAMADDR | LCD_SETCGRAMADDR | LCD_FUNCTIONSET)) {
+        // Runs carry their address
+        return;
+    } else if (value & LCD_CURSORSHIFT) {
+        if (value & LCD_DISPLAYMOVE) {
+            LCD_mirrorFlush(m);
+            moveDisplay(m, lcd, (value & LCD_MOVERIGHT) != 0);
+            emit(m, LCD_MIRROR_SHIFT);
+            emit(m, value & LCD_MOVERIGHT);
+        }
+    } else if (value & LCD_DISPLAYCONTROL) {
+        LCD_mirrorFlush(m);
+        emit(m, LCD_MIRROR_CONTROL);
+        emit(m, value & 0x07);
+    } else if (value & LCD_ENTRYMODESET) {
+        LCD_mirrorFlush(m);
+        emit(m, LCD_MIRROR_ENTRY);
+        emit(m, value & 0x03);
+    } else if (value & LCD_RETURNHOME) {
+        LCD_mirrorFlush(m);
+        m->shift = 0;
+        emit(m, LCD_MIRROR_HOME);
+    } else if (value == LCD_CLEARDISPLAY) {
+        discardRun(m);
+        clearShadow(m);
+        emit(m, LCD_MIRROR_CLEAR);
+    }
+
+    if (m->keyframeEvery != 0 && m->sinceKeyframe >= m->keyframeEvery)
+        LCD_mirrorKeyframe(m, lcd);
+}
+
+void LCD_initMirror(struct LCDMirror *m, struct LCD *lcd, uint8_t *shadow, uint8_t *cgram, void (*sink)(uint8_t byte), uint16_t keyframeEvery)
+{
+    uint8_t i;
+
+    m->shadow = shadow;
+    m->cgram = cgram;
+    m->sink = sink;
+    m->keyframeEvery = keyframeEvery;
+    m->runLen = 0;
+    clearShadow(m);
+
+    if (cgram != NULL) {
+        for (i = 0; i < 64; i++)
+            cgram[i] = 0;
+    }
+
+    LCD_initTracker(&m->track, lcd);
+    LCD_addHook(lcd, &m->hook, &mirrorSend);
+
+    // Start from a known DDRAM content, this also sends the first keyframe
+    LCD_clear(lcd);
+    LCD_mirrorKeyframe(m, lcd);
+}
+
+void LCD_mirrorFlush(struct LCDMirror *m)
+{
+    uint8_t i;
+
+    if (m->runLen == 0)
+        return;
+
+    emit(m, (m->runCgram ? LCD_MIRROR_CGRAM : LCD_MIRROR_DDRAM) | m->runLen);
+    emit(m, m->runAddr);
+    for (i = 0; i < m->runLen; i++)
+        emit(m, m->run[i]);
+
+    m->runLen = 0;
+}
+
+void LCD_mirrorKeyframe(struct LCDMirror *m, struct LCD *lcd)
+{
+    uint8_t i;
+
+    discardRun(m);
+
+    m->sink(LCD_MIRROR_KEYFRAME);
+    m->sink('L');
+    m->sink('K');
+    m->sink(lcd->numlines);
+    m->sink(lcd->cols);
+    m->sink(m->track.control);
+    m->sink(m->track.entry);
+    m->sink(m->cgram != NULL);
+    m->sink(m->shift);
+
+    for (i = 0; i < LCD_MIRROR_DDRAM_SIZE; i++)
+        m->sink(m->shadow[i]);
+
+    if (m->cgram != NULL) {
+        for (i = 0; i < 64; i++)
+            m->sink(m->cgram[i]);
+    }
+
+    m->sinceKeyframe = 0;
+}
@@ -0,0 +1,148 @@
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// Numeric fields that only resend the digits that changed.
+#include <stdio.h>
+#include "LCDOdometer.h"
+
+// At most every other cell starts a run
+#define MAX_RUNS    ((LCD_ODOMETER_WIDTH + 1) / 2)
+
+// Address commands needed to write the runs in one direction. ac is the
+// address counter of the LCD, 0xFF if unknown.
+static uint8_t jumps(uint8_t base, const uint8_t start[], const uint8_t end[], uint8_t n, bool rtl, uint8_t ac)
+{
+    uint8_t count = 0;
+    uint8_t i, r;
+
+    for (i = 0; i < n; i++) {
+        r = rtl ? n - 1 - i : i;
+        if (ac != base + (rtl ? end[r] : start[r]))
+            count++;
+        ac = rtl ? base + start[r] - 1 : base + end[r] + 1;
+    }
+    return count;
+}
+
+static void update(struct LCD *this, struct LCDOdometer *od, const uint8_t cells[])
+{
+    uint8_t start[MAX_RUNS], end[MAX_RUNS];
+    uint8_t base = LCD_rowAddress(this, od->row) + od->col;
+    uint8_t ac = 0xFF;
+    uint8_t n = 0;
+    uint8_t i, r, c, costLeft, costRight;
+    bool rtlNow, rtl;
+
+    // Runs of changed cells, a single unchanged cell between two runs costs
+    // the same as an address command and is written over
+    for (i = 0; i < od->width; i++) {
+        if (od->valid && od->shown[i] == cells[i])
+            continue;
+        if (n > 0 && i <= end[n - 1] + 2)
+            end[n - 1] = i;
+        else {
+            start[n] = i;
+            end[n] = i;
+            n++;
+        }
+    }
+
+    if (n == 0)
+        return;
+
+    if (od->track != NULL && !od->track->cgram)
+        ac = od->track->addr;
+
+    rtlNow = !(this->displaymode & LCD_ENTRYLEFT);
+    costLeft = jumps(base, start, end, n, false, ac) + (rtlNow ? 2 : 0);
+    costRight = jumps(base, start, end, n, true, ac) + (rtlNow ? 0 : 2);
+    rtl = rtlNow ? (costRight <= costLeft) : (costRight < costLeft);
+
+    if (rtl != rtlNow) {
+        if (rtl)
+            LCD_rightToLeft(this);
+        else
+            LCD_leftToRight(this);
+    }
+
+    for (i = 0; i < n; i++) {
+        r = rtl ? n - 1 - i : i;
+        if (ac != base + (rtl ? end[r] : start[r]))
+            LCD_command(this, LCD_SETDDRAMADDR | (base + (rtl ? end[r] : start[r])));
+
+        if (rtl) {
+            for (c = end[r] + 1; c > start[r]; c--)
+                LCD_write(this, cells[c - 1]);
+            ac = base + start[r] - 1;
+        } else {
+            for (c = start[r]; c <= end[r]; c++)
+                LCD_write(this, cells[c]);
+            ac = base + end[r] + 1;
+        }
+    }
+
+    // Back to the direction the application uses
+    if (rtl != rtlNow) {
+        if (rtlNow)
+            LCD_rightToLeft(this);
+        else
+            LCD_leftToRight(this);
+    }
+
+    for (i = 0; i < od->width; i++)
+        od->shown[i] = cells[i];
+    od->valid = true;
+}
+
+// Fill the cells right to left, the digits that don't fit are dropped. The
+// first cell is kept for the sign of a negative value.
+static void render(struct LCDOdometer *od, uint16_t value, bool negative, uint8_t cells[])
+{
+    int8_t i = od->width - 1;
+    int8_t stop = negative ? 1 : 0;
+
+    while (i >= stop) {
+        cells[i--] = '0' + (value % 10);
+        value /= 10;
+        if (value == 0)
+            break;
+    }
+
+    if (negative && i >= 0 && od->pad != '0')
+        cells[i--] = '-';
+
+    while (i >= 0)
+        cells[i--] = od->pad;
+
+    if (negative && od->pad == '0')
+        cells[0] = '-';
+}
+
+void LCD_initOdometer(struct LCDOdometer *od, uint8_t col, uint8_t row, uint8_t width, uint8_t pad,
+                      const struct LCDTracker *track)
+{
+    od->col = col;
+    od->row = row;
+    if (width == 0)
+        width = 1;
+    od->width = (width < LCD_ODOMETER_WIDTH) ? width : LCD_ODOMETER_WIDTH;
+    od->pad = pad;
+    od->valid = false;
+    od->track = track;
+}
+
+void LCD_odometerUInt(struct LCD *this, struct LCDOdometer *od, uint16_t value)
+{
+    uint8_t cells[LCD_ODOMETER_WIDTH];
+
+    render(od, value, false, cells);
+    update(this, od, cells);
+}
+
+void LCD_odometerSInt(struct LCD *this, struct LCDOdometer *od, int16_t value)
+{
+    uint8_t cells[LCD_ODOMETER_WIDTH];
+
+    render(od, (value < 0) ? (uint16_t)(-(int32_t)value) : (uint16_t)value, value < 0, cells);
+    update(this, od, cells);
+}
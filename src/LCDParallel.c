@@ -21,6 +21,7 @@
 #define write8bits(this, value)                         \
     do {                                                \
         *(this->i.pi.lcd_dport) = value;                \
+        LCD_portChanged(this->i.pi.lcd_dport);          \
         pulseEnable(this);                              \
     } while (0)
 
@@ -29,22 +30,36 @@
 #define write4bits(this, value)                         \
     do {                                                \
         *(this->i.pi.lcd_dport) &= 0xF0;                \
+        LCD_portChanged(this->i.pi.lcd_dport);          \
         *(this->i.pi.lcd_dport) |= (value) & 0x0F;      \
+        LCD_portChanged(this->i.pi.lcd_dport);          \
         pulseEnable(this);                              \
     } while (0)
+#define NIBBLE_MASK 0x0F
+#define readNibble(value)   ((value) & 0x0F)
 #else
 #define write4bits(this, value)                         \
     do {                                                \
-        *(this->lcd_dport) &= 0x0F;                     \
-        *(this->lcd_dport) |= (value & 0x0F) << 4;      \
+        *(this->i.pi.lcd_dport) &= 0x0F;                \
+        LCD_portChanged(this->i.pi.lcd_dport);          \
+        *(this->i.pi.lcd_dport) |= ((value) & 0x0F) << 4; \
+        LCD_portChanged(this->i.pi.lcd_dport);          \
         pulseEnable(this);                              \
     } while (0)
+#define NIBBLE_MASK 0xF0
+#define readNibble(value)   ((value) >> 4)
 #endif
 
+// Bus time per byte: enable pulses and the wait between nibbles
+static const struct LCDCosts costs8bit = { 6, EXEC_TIME, HOME_CLEAR_EXEC };
+static const struct LCDCosts costs4bit = { 16, EXEC_TIME, HOME_CLEAR_EXEC };
+
 /************ low level data pushing commands **********/
 // Parallel Send Data/Command to the LCD
 void LCD_sendParallel(struct LCD *this, uint8_t value, uint8_t mode)
 {
+    LCD_waitReady(this);
+
     // Only interested in COMMAND or DATA
     if (mode == DATA)
         setBit(this->i.pi.lcd_cport, this->i.pi.rs_pin);
@@ -61,7 +76,92 @@ void LCD_sendParallel(struct LCD *this, uint8_t value, uint8_t mode)
       waitUsec(5);
       write4bits (this, value);
    }
-    waitUsec(EXEC_TIME); // wait for the command to execute by the LCD
+    LCD_execBusy(this, value, mode); // wait for the command to execute by the LCD
+}
+
+// Raise enable and sample the data port
+static uint8_t pulseRead(struct LCD *this)
+{
+    uint8_t value;
+
+    setBit(this->i.pi.lcd_cport, this->i.pi.enable_pin);
+    waitUsec(1); // data delay time is < 360ns
+    value = *(this->i.pi.lcd_dread);
+    clearBit(this->i.pi.lcd_cport, this->i.pi.enable_pin);
+    waitUsec(1); // enable cycle time must be > 1us
+
+    return value;
+}
+
+// Parallel Read busy flag and address (COMMAND) or Data (DATA) from the LCD
+static uint8_t LCD_readParallel(struct LCD *this, uint8_t mode)
+{
+    uint8_t value;
+
+    LCD_waitReady(this);
+
+    if (mode == DATA)
+        setBit(this->i.pi.lcd_cport, this->i.pi.rs_pin);
+    else
+        clearBit(this->i.pi.lcd_cport, this->i.pi.rs_pin);
+
+    setBit(this->i.pi.lcd_cport, this->i.pi.rw_pin);
+
+    if (this->displayfunction & LCD_8BITMODE)
+    {
+        *(this->i.pi.lcd_dtris) = 0xFF;
+        LCD_portChanged(this->i.pi.lcd_dtris);
+        value = pulseRead(this);
+        *(this->i.pi.lcd_dtris) = 0x00;
+        LCD_portChanged(this->i.pi.lcd_dtris);
+    }
+    else
+    {
+        *(this->i.pi.lcd_dtris) |= NIBBLE_MASK;
+        LCD_portChanged(this->i.pi.lcd_dtris);
+        value = readNibble(pulseRead(this)) << 4;
+        value |= readNibble(pulseRead(this));
+        *(this->i.pi.lcd_dtris) &= ~NIBBLE_MASK;
+        LCD_portChanged(this->i.pi.lcd_dtris);
+    }
+
+    clearBit(this->i.pi.lcd_cport, this->i.pi.rw_pin);
+
+    // Reading the RAM moves the address counter, that takes the LCD a while
+    if (mode == DATA)
+        LCD_execBusy(this, value, DATA);
+
+    return value;
+}
+
+// Put a running LCD back in the interface mode set by begin
+static void LCD_resyncParallel(struct LCD *this)
+{
+    LCD_waitReady(this);
+
+    if (! (this->displayfunction & LCD_8BITMODE))
+    {
+        clearBit(this->i.pi.lcd_cport, this->i.pi.rs_pin);
+
+        // The init sequence of the datasheet (figure 24): if the LCD is
+        // expecting a low nibble the first 0x3 completes an unknown command
+        // and the next two set 8 bit mode, otherwise all three do. Either
+        // way the LCD is in 8 bit mode before the 0x2.
+        write4bits(this, 0x03);
+        __delay_us(4500);   // wait min 4.1ms, longer than LCD_waitReady covers
+
+        write4bits(this, 0x03);
+        __delay_us(4500);   // wait min 4.1ms
+
+        write4bits(this, 0x03);
+        __delay_us(150);
+
+        // Finally, set to 4-bit interface
+        write4bits(this, 0x02);
+        LCD_setBusy(this, EXEC_TIME);
+    }
+
+    LCD_command(this, LCD_FUNCTIONSET | this->displayfunction);
 }
 
 void LCD_beginParallel(struct LCD *this, uint8_t cols, uint8_t lines, uint8_t dotsize)
@@ -118,6 +218,7 @@ void LCD_beginParallel(struct LCD *this, uint8_t cols, uint8_t lines, uint8_t do
       
       // finally, set to 4-bit interface
       write4bits(this, 0x02); 
+      LCD_setBusy(this, EXEC_TIME);
    } 
    else 
    {
@@ -145,11 +246,22 @@ void LCD_beginParallel(struct LCD *this, uint8_t cols, uint8_t lines, uint8_t do
    
    // clear the LCD
    LCD_clear(this);
+
+#ifdef LCD_CALIBRATE
+   // learn the execution times while the screen is blank
+   LCD_calibrate(this);
+#endif
    
    // Initialize to default text direction (for romance languages)
    this->displaymode = LCD_ENTRYLEFT | LCD_ENTRYSHIFTDECREMENT;
    // set the entry mode
    LCD_command(this, LCD_ENTRYMODESET | this->displaymode);
+#ifdef LCD_LAZY_MODES
+   // The entry mode was sent above, the display control is still pending
+   this->sentmode = this->displaymode;
+   this->sentcontrol = 0xFF;
+   LCD_flushModes(this);
+#endif
 }
 
 void LCD_initParallel(struct LCD *this, uint8_t bitmode, volatile uint8_t *lcd_dport, volatile uint8_t *lcd_cport, uint8_t rs_pin, uint8_t enable_pin)
@@ -165,6 +277,33 @@ void LCD_initParallel(struct LCD *this, uint8_t bitmode, volatile uint8_t *lcd_d
     clearBit(lcd_cport, rs_pin);
     clearBit(lcd_cport, enable_pin);
 
+#ifdef LCD_USE_TIMER
+    this->readyAt = LCD_timerNow();
+#endif
+#ifdef LCD_CALIBRATE
+    LCD_defaultTiming(this);
+#endif
+
+    this->costs = (bitmode & LCD_8BITMODE) ? &costs8bit : &costs4bit;
+    this->hook = NULL;
+    this->queued = false;
     this->send = &LCD_sendParallel;
     this->begin = &LCD_beginParallel;
+    this->resync = &LCD_resyncParallel;
+    this->read = NULL;
+}
+
+void LCD_initParallelRW(struct LCD *this, uint8_t bitmode, volatile uint8_t *lcd_dport, volatile uint8_t *lcd_cport, uint8_t rs_pin, uint8_t enable_pin,
+                        uint8_t rw_pin, volatile uint8_t *lcd_dtris, volatile uint8_t *lcd_dread)
+{
+    LCD_initParallel(this, bitmode, lcd_dport, lcd_cport, rs_pin, enable_pin);
+
+    this->i.pi.rw_pin = rw_pin;
+    this->i.pi.lcd_dtris = lcd_dtris;
+    this->i.pi.lcd_dread = lcd_dread;
+
+    // We only read on request, the rest of the time we write
+    clearBit(lcd_cport, rw_pin);
+
+    this->read = &LCD_readParallel;
 }
\ No newline at end of file
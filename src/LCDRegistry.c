@@ -0,0 +1,79 @@
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// Live values for the fields of a screen template.
+#include <stdio.h>
+#include "LCDRegistry.h"
+
+// Bus time to render a field: the cursor command plus one write per cell
+#define fieldCost(this, f)                                      \
+    (LCD_estimateCostUs(this, LCD_OP_SETCURSOR, 0) +            \
+     LCD_estimateCostUs(this, LCD_OP_WRITE, (f)->width))
+
+void LCD_initRegistry(struct LCDRegistry *reg, const struct LCDTemplate *tpl, struct LCDLiveField *fields, uint16_t period, uint16_t budget)
+{
+    uint8_t i;
+
+    reg->tpl = tpl;
+    reg->fields = fields;
+    reg->period = period;
+    reg->budget = budget;
+
+    for (i = 0; i < tpl->numfields; i++) {
+        fields[i].value = 0;
+        fields[i].dirty = 0;
+        fields[i].priority = 0;
+    }
+
+    // Allow a frame on the first refresh
+    reg->lastFrame = 0;
+    reg->lastFrame -= period;
+}
+
+bool LCD_refreshFields(struct LCD *this, struct LCDRegistry *reg, uint16_t now)
+{
+    struct LCDLiveField *live;
+    uint16_t spent, value;
+    uint8_t i, best, rendered;
+
+    if ((uint16_t)(now - reg->lastFrame) < reg->period)
+        return false;
+
+    reg->lastFrame = now;
+    spent = 0;
+    rendered = 0;
+
+    // A field published again while the frame is rendered can be picked
+    // twice, bounding the passes keeps the frame time bounded too.
+    while (rendered < reg->tpl->numfields) {
+        // Pick the dirty field with the highest priority that fits
+        best = 0xFF;
+        for (i = 0; i < reg->tpl->numfields; i++) {
+            live = &reg->fields[i];
+            if (!live->dirty)
+                continue;
+            if (rendered != 0 && spent + fieldCost(this, &reg->tpl->fields[i]) > reg->budget)
+                continue;
+            if (best == 0xFF || live->priority > reg->fields[best].priority)
+                best = i;
+        }
+
+        if (best == 0xFF)
+            break;
+
+        // Take the value, if the interrupt publishes while it is being read
+        // the dirty flag is set again and it is read once more.
+        live = &reg->fields[best];
+        do {
+            live->dirty = 0;
+            value = live->value;
+        } while (live->dirty);
+
+        LCD_setFieldUInt(this, reg->tpl, best, value);
+
+        spent += fieldCost(this, &reg->tpl->fields[best]);
+        rendered++;
+    }
+
+    return rendered != 0;
+}
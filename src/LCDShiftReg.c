@@ -15,58 +15,299 @@
 #define SR_RW_BIT 0b00100000   // RW can be pinned low since we only send
 #define SR_RS_BIT 0b01000000   // LOW: command. HIGH: character.
 
+// Bus time per byte: the shifts and the enable pulses
+static const struct LCDCosts costsSR[] = {
+    { 5 * LCD_SR_SHIFT_TIME, EXEC_TIME, HOME_CLEAR_EXEC },          // LCD_SR_ENABLE_BIT, RS setup
+    { 2 * (LCD_SR_SHIFT_TIME + 1), EXEC_TIME, HOME_CLEAR_EXEC },    // LCD_SR_ENABLE_STROBE
+    { LCD_SR_SHIFT_TIME + 1, EXEC_TIME, HOME_CLEAR_EXEC },          // LCD_SR_8BIT
+    { 5 * LCD_CHAIN_MAX * LCD_SR_SHIFT_TIME, EXEC_TIME, HOME_CLEAR_EXEC }, // LCD_SR_CHAIN, one LCD written alone
+};
+
+static const uint8_t pinMask[8] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80 };
+
+// Shift one bit of val, bit is a constant mask so no shifting is done at run time
+#define shiftBit(port, dmask, cmask, val, bit)  \
+    do {                                        \
+        if ((val) & (bit))                      \
+            setMask(port, dmask);               \
+        else                                    \
+            clearMask(port, dmask);             \
+        setMask(port, cmask);                   \
+        clearMask(port, cmask);                 \
+    } while (0)
+
 static void shiftOut(volatile uint8_t *port, uint8_t dataPin, uint8_t clockPin, uint8_t val)
 {
-        uint8_t i;
+    uint8_t dmask = pinMask[dataPin];
+    uint8_t cmask = pinMask[clockPin];
 
-        for (i = 0; i < 8; i++)  {
-            if ((val & (1 << i)) != 0)
-                setBit(port, dataPin);
-            else
-                clearBit(port, dataPin);
-                        
-            setBit(port, clockPin);
-            clearBit(port, clockPin);
-        }
+    shiftBit(port, dmask, cmask, val, 0x01);
+    shiftBit(port, dmask, cmask, val, 0x02);
+    shiftBit(port, dmask, cmask, val, 0x04);
+    shiftBit(port, dmask, cmask, val, 0x08);
+    shiftBit(port, dmask, cmask, val, 0x10);
+    shiftBit(port, dmask, cmask, val, 0x20);
+    shiftBit(port, dmask, cmask, val, 0x40);
+    shiftBit(port, dmask, cmask, val, 0x80);
 }
 
-static void _pushOut(struct LCD *this, uint8_t nibble)
+static void _pushOut(struct LCD *this, uint8_t value)
 {
+    uint8_t smask = pinMask[this->i.sri.strobe_pin];
+
     // Make data available for pushing to the LCD.
-    shiftOut(this->i.sri.sr_port, this->i.sri.srdata_pin, this->i.sri.srclock_pin, nibble);
+    shiftOut(this->i.sri.sr_port, this->i.sri.srdata_pin, this->i.sri.srclock_pin, value);
 
     // Make new data active.
-    setBit(this->i.sri.sr_port, this->i.sri.strobe_pin);
-    waitUsec(1); // strobe pulse must be >450ns (old code had 10ms)
-    clearBit(this->i.sri.sr_port, this->i.sri.strobe_pin);
-    waitUsec(40); // commands need > 37us to settle
+    this->i.sri.out = value;
+    setMask(this->i.sri.sr_port, smask);
+    if (this->i.sri.mode != LCD_SR_ENABLE_BIT)
+        waitUsec(1); // the strobe is also the LCD enable, pulse must be >450ns
+    clearMask(this->i.sri.sr_port, smask);
+}
+
+// Chain of shift registers
+// ---------------------------------------------------------------------------
+#define queueIndex(c, i, n)     (((c)->head[i] + (n)) & (LCD_CHAIN_QUEUE - 1))
+
+// Shift the outputs of every register and latch them, enable is a mask of
+// the LCDs whose enable bit is raised. The last register is shifted first.
+static void chainBurst(struct LCDChain *c, uint8_t enable)
+{
+    uint8_t smask = pinMask[c->strobe];
+    uint8_t i = c->count;
+
+    while (i-- > 0)
+        shiftOut(c->port, c->data, c->clock, c->out[i] | ((enable & (1 << i)) ? SR_EN_BIT : 0));
+
+    setMask(c->port, smask);
+    clearMask(c->port, smask);
+}
+
+#ifdef LCD_USE_TIMER
+static bool chainReady(struct LCDChain *c, uint8_t i)
+{
+    uint16_t remaining = c->readyAt[i] - LCD_timerNow();
+
+    return remaining == 0 || remaining > HOME_CLEAR_EXEC;
+}
+#else
+#define chainReady(c, i)    true
+#endif
+
+// Send the next byte of every LCD that has one and is ready, a nibble per
+// LCD in each pair of bursts. Returns false if nothing is left to send.
+static bool chainRound(struct LCDChain *c)
+{
+    uint8_t value[LCD_CHAIN_MAX];
+    uint8_t sel = 0;
+    uint8_t pending = 0;
+    uint8_t slow = 0;
+    uint8_t cgram;
+    bool setup = false;
+    uint8_t i, rs;
+
+    for (i = 0; i < c->count; i++) {
+        if (c->len[i] == 0)
+            continue;
+        pending++;
+        if (!chainReady(c, i))
+            continue;
+
+        value[i] = c->queue[i][c->head[i]];
+        rs = (c->mode[i] & (1 << c->head[i])) ? SR_RS_BIT : 0;
+        c->head[i] = queueIndex(c, i, 1);
+        c->len[i]--;
+        sel |= 1 << i;
+
+        // Clear and home are the only slow commands, CGRAM accesses get
+        // CGRAM_EXTRA as LCD_createChar gives them
+        if (!rs) {
+            if (value[i] < LCD_ENTRYMODESET) {
+                slow |= 1 << i;
+                c->cgram &= ~(1 << i);
+            } else if (value[i] & LCD_SETDDRAMADDR) {
+                c->cgram &= ~(1 << i);
+            } else if (value[i] & LCD_SETCGRAMADDR) {
+                c->cgram |= 1 << i;
+            }
+        }
+
+        if ((c->out[i] ^ rs) & SR_RS_BIT)
+            setup = true;
+        c->out[i] = rs | (value[i] >> 4);
+    }
+
+    if (sel != 0) {
+        // RS has to settle before enable rises
+        if (setup)
+            chainBurst(c, 0);
+
+        chainBurst(c, sel);     // Enable high
+        chainBurst(c, 0);       // The LCDs latch the high nibble
+
+        for (i = 0; i < c->count; i++) {
+            if (sel & (1 << i))
+                c->out[i] = (c->out[i] & SR_RS_BIT) | (value[i] & 0x0F);
+        }
+        chainBurst(c, sel);
+        chainBurst(c, 0);
+
+        cgram = sel & c->cgram;
+#ifdef LCD_USE_TIMER
+        for (i = 0; i < c->count; i++) {
+            if (slow & (1 << i))
+                c->readyAt[i] = LCD_timerNow() + HOME_CLEAR_EXEC;
+            else if (cgram & (1 << i))
+                c->readyAt[i] = LCD_timerNow() + EXEC_TIME + CGRAM_EXTRA;
+            else if (sel & (1 << i))
+                c->readyAt[i] = LCD_timerNow() + EXEC_TIME;
+        }
+#else
+        if (slow != 0)
+            waitUsec(HOME_CLEAR_EXEC);
+        else if (cgram != 0)
+            waitUsec(EXEC_TIME + CGRAM_EXTRA);
+        else
+            waitUsec(EXEC_TIME);
+#endif
+    }
+
+    return pending != 0;
+}
+
+void LCD_chainFlush(struct LCDChain *c)
+{
+    while (chainRound(c))
+        ;
+}
+
+// Queue a byte, a full queue is flushed first
+static void LCD_chainSend(struct LCD *this, uint8_t value, uint8_t mode)
+{
+    struct LCDChain *c = this->i.sri.chain;
+    uint8_t i = this->i.sri.index;
+    uint8_t n;
+
+    while (c->len[i] == LCD_CHAIN_QUEUE)
+        chainRound(c);
+
+    n = queueIndex(c, i, c->len[i]);
+    c->queue[i][n] = value;
+    if (mode == DATA)
+        c->mode[i] |= 1 << n;
+    else
+        c->mode[i] &= ~(1 << n);
+    c->len[i]++;
+}
+
+// Latch a nibble into one LCD of a chain right away, used by the init sequence
+static void chainNibble(struct LCD *this, uint8_t nibble)
+{
+    struct LCDChain *c = this->i.sri.chain;
+    uint8_t i = this->i.sri.index;
+
+    LCD_chainFlush(c);
+
+    nibble &= ~SR_EN_BIT;
+    if ((c->out[i] ^ nibble) & SR_RS_BIT) {
+        c->out[i] = nibble;
+        chainBurst(c, 0);
+    }
+
+    c->out[i] = nibble;
+    chainBurst(c, 1 << i);
+    chainBurst(c, 0);
+
+#ifdef LCD_USE_TIMER
+    c->readyAt[i] = LCD_timerNow() + EXEC_TIME;
+#endif
 }
 
+// Latch a nibble into the LCD, the caller has to wait for the LCD to execute
+// it once the whole command has been sent.
 static void write4bits(struct LCD *this, uint8_t nibble)
 {
     nibble &= ~SR_RW_BIT; // set RW LOW (we do this always since we only write).
 
-    // Send a High transition to display the data that was pushed
-    nibble |=  SR_EN_BIT; // LCD Data Enable HIGH
-    _pushOut(this, nibble);
-    nibble &= ~SR_EN_BIT; // LCD Data Enable LOW
-    _pushOut(this, nibble); 
+    if (this->i.sri.mode == LCD_SR_CHAIN) {
+        chainNibble(this, nibble);
+    } else if (this->i.sri.mode == LCD_SR_ENABLE_STROBE) {
+        // The LCD latches the nibble on the falling edge of the strobe
+        _pushOut(this, nibble);
+    } else {
+        // RS has to settle before enable rises
+        if ((this->i.sri.out ^ nibble) & SR_RS_BIT)
+            _pushOut(this, nibble);
+
+        // Send a High transition to display the data that was pushed.
+        // Shifting the next value takes longer than the minimum enable pulse.
+        _pushOut(this, nibble | SR_EN_BIT); // LCD Data Enable HIGH
+        _pushOut(this, nibble);             // LCD Data Enable LOW
+    }
 }
 
 // Parallel Send Data/Command to the LCD
 static void LCD_shiftRegSend(struct LCD *this, uint8_t value, uint8_t mode)
 {
    uint8_t nibble;
+   uint8_t rs;
    
-   mode = mode ? SR_RS_BIT : 0; // RS bit; LOW: command.  HIGH: character.
+   LCD_waitReady(this);
+
+   rs = mode ? SR_RS_BIT : 0; // RS bit; LOW: command.  HIGH: character.
 
    nibble = value >> 4; // Get high nibble.
-   write4bits(this, nibble | mode);
+   write4bits(this, nibble | rs);
 
    //delay(1); // This was in the LCD3 code but does not seem needed -- merlin
 
    nibble = value & 0x0f; // Get low nibble
-   write4bits(this, nibble | mode);
+   write4bits(this, nibble | rs);
+
+   LCD_execBusy(this, value, mode); // commands need > 37us to settle
+}
+
+// Send Data/Command to an 8 bit LCD, one shift per byte
+static void LCD_shiftReg8Send(struct LCD *this, uint8_t value, uint8_t mode)
+{
+    LCD_waitReady(this);
+
+    if (mode == DATA)
+        setBit(this->i.sri.sr_port, this->i.sri.rs_pin);
+    else
+        clearBit(this->i.sri.sr_port, this->i.sri.rs_pin);
+
+    _pushOut(this, value);
+    LCD_execBusy(this, value, mode); // wait for the command to execute by the LCD
+}
+
+// Put a running LCD back in the interface mode set by begin
+static void LCD_resyncShiftReg(struct LCD *this)
+{
+    LCD_waitReady(this);
+
+    if (this->i.sri.mode != LCD_SR_8BIT)
+    {
+        // The init sequence of the datasheet (figure 24): if the LCD is
+        // expecting a low nibble the first 0x3 completes an unknown command
+        // and the next two set 8 bit mode, otherwise all three do. Either
+        // way the LCD is in 8 bit mode before the 0x2.
+        write4bits(this, (LCD_FUNCTIONSET | LCD_8BITMODE) >> 4);
+        __delay_us(4500);   // wait min 4.1ms, longer than LCD_waitReady covers
+
+        write4bits(this, (LCD_FUNCTIONSET | LCD_8BITMODE) >> 4);
+        __delay_us(4500);   // wait min 4.1ms
+
+        write4bits(this, (LCD_FUNCTIONSET | LCD_8BITMODE) >> 4);
+        __delay_us(150);
+
+        // Finally, set to 4-bit interface
+        write4bits(this, (LCD_FUNCTIONSET | LCD_4BITMODE) >> 4);
+        LCD_setBusy(this, EXEC_TIME);
+    }
+
+    LCD_command(this, LCD_FUNCTIONSET | this->displayfunction);
 }
 
 void LCD_beginShiftReg(struct LCD *this, uint8_t cols, uint8_t lines, uint8_t dotsize) 
@@ -99,19 +340,39 @@ void LCD_beginShiftReg(struct LCD *this, uint8_t cols, uint8_t lines, uint8_t do
        __delay_ms(10);
    }
 
-   // This init is copied verbatim from the spec sheet.
-   // 8 bit codes are shifted to 4 bit
-   write4bits(this, (LCD_FUNCTIONSET | LCD_8BITMODE) >> 4);
-   __delay_us(4500);  // wait more than 4.1ms
-   
-   // Second try
-   write4bits(this, (LCD_FUNCTIONSET | LCD_8BITMODE) >> 4);
-   __delay_us(150);
-   // Third go
-   write4bits(this, (LCD_FUNCTIONSET | LCD_8BITMODE) >> 4);
-   
-   // And finally, set to 4-bit interface
-   write4bits(this, (LCD_FUNCTIONSET | LCD_4BITMODE) >> 4);
+   if (this->i.sri.mode == LCD_SR_8BIT)
+   {
+      // this is according to the hitachi HD44780 datasheet
+      // page 45 figure 23
+      LCD_command(this, LCD_FUNCTIONSET | this->displayfunction);
+      __delay_us(4500);  // wait more than 4.1ms
+
+      // second try
+      LCD_command(this, LCD_FUNCTIONSET | this->displayfunction);
+      __delay_us(150);
+
+      // third go
+      LCD_command(this, LCD_FUNCTIONSET | this->displayfunction);
+   }
+   else
+   {
+      // This init is copied verbatim from the spec sheet.
+      // 8 bit codes are shifted to 4 bit
+      write4bits(this, (LCD_FUNCTIONSET | LCD_8BITMODE) >> 4);
+      __delay_us(4500);  // wait more than 4.1ms
+
+      // Second try
+      write4bits(this, (LCD_FUNCTIONSET | LCD_8BITMODE) >> 4);
+      __delay_us(150);
+      // Third go
+      write4bits(this, (LCD_FUNCTIONSET | LCD_8BITMODE) >> 4);
+      LCD_setBusy(this, EXEC_TIME);
+
+      // And finally, set to 4-bit interface
+      LCD_waitReady(this);
+      write4bits(this, (LCD_FUNCTIONSET | LCD_4BITMODE) >> 4);
+      LCD_setBusy(this, EXEC_TIME);
+   }
    
    // Set # lines, font size, etc.
    LCD_command(this, LCD_FUNCTIONSET | this->displayfunction);
@@ -125,9 +386,15 @@ void LCD_beginShiftReg(struct LCD *this, uint8_t cols, uint8_t lines, uint8_t do
    // set the entry mode
    LCD_command(this, LCD_ENTRYMODESET | this->displaymode);
    LCD_home(this);
+#ifdef LCD_LAZY_MODES
+   // The entry mode was sent above, the display control is still pending
+   this->sentmode = this->displaymode;
+   this->sentcontrol = 0xFF;
+   LCD_flushModes(this);
+#endif
 }
 
-void LCD_initShiftReg(struct LCD *this, volatile uint8_t *sr_port, uint8_t srdata, uint8_t srclock, uint8_t strobe)
+static void initShiftReg(struct LCD *this, uint8_t mode, volatile uint8_t *sr_port, uint8_t srdata, uint8_t srclock, uint8_t strobe)
 {
     this->displayfunction = LCD_4BITMODE | LCD_1LINE | LCD_5x10DOTS;
     
@@ -136,14 +403,89 @@ void LCD_initShiftReg(struct LCD *this, volatile uint8_t *sr_port, uint8_t srdat
     this->i.sri.srdata_pin  = srdata; 
     this->i.sri.srclock_pin = srclock; 
     this->i.sri.strobe_pin = strobe;
+    this->i.sri.mode = mode;
+    this->i.sri.out = 0;
+    this->costs = &costsSR[mode];
 
    // Initialize _strobe_pin at low.
     clearBit(sr_port, strobe);
+
+#ifdef LCD_USE_TIMER
+    this->readyAt = LCD_timerNow();
+#endif
+#ifdef LCD_CALIBRATE
+    LCD_defaultTiming(this);
+#endif
     
+    this->hook = NULL;
+    this->queued = false;
+    this->send = &LCD_shiftRegSend;
+    this->begin = &LCD_beginShiftReg;
+    this->resync = &LCD_resyncShiftReg;
+    this->read = NULL; // RW is pinned low
+}
+
+void LCD_initShiftReg(struct LCD *this, volatile uint8_t *sr_port, uint8_t srdata, uint8_t srclock, uint8_t strobe)
+{
+    initShiftReg(this, LCD_SR_ENABLE_BIT, sr_port, srdata, srclock, strobe);
+
     // Little trick to force a pulse of the LCD enable bit and make sure it is
     // low before we start further writes since this is assumed.
     write4bits(this, 0);
-    
-    this->send = &LCD_shiftRegSend;
-    this->begin = &LCD_beginShiftReg;
+}
+
+void LCD_initShiftRegStrobe(struct LCD *this, volatile uint8_t *sr_port, uint8_t srdata, uint8_t srclock, uint8_t strobe)
+{
+    // The enable follows the strobe, so it is already low
+    initShiftReg(this, LCD_SR_ENABLE_STROBE, sr_port, srdata, srclock, strobe);
+}
+
+void LCD_initShiftReg8(struct LCD *this, volatile uint8_t *sr_port, uint8_t srdata, uint8_t srclock, uint8_t strobe, uint8_t rs)
+{
+    initShiftReg(this, LCD_SR_8BIT, sr_port, srdata, srclock, strobe);
+
+    this->displayfunction = LCD_8BITMODE | LCD_1LINE | LCD_5x8DOTS;
+    this->i.sri.rs_pin = rs;
+    clearBit(sr_port, rs);
+
+    this->send = &LCD_shiftReg8Send;
+}
+
+void LCD_initChain(struct LCDChain *chain, volatile uint8_t *sr_port, uint8_t srdata, uint8_t srclock, uint8_t strobe, uint8_t count)
+{
+    uint8_t i;
+
+    chain->port = sr_port;
+    chain->data = srdata;
+    chain->clock = srclock;
+    chain->strobe = strobe;
+    chain->count = (count < LCD_CHAIN_MAX) ? count : LCD_CHAIN_MAX;
+    chain->cgram = 0;
+
+    for (i = 0; i < LCD_CHAIN_MAX; i++) {
+        chain->out[i] = 0;
+        chain->head[i] = 0;
+        chain->len[i] = 0;
+#ifdef LCD_USE_TIMER
+        chain->readyAt[i] = LCD_timerNow();
+#endif
+    }
+
+    // Make sure every enable output starts low
+    clearBit(sr_port, strobe);
+    chainBurst(chain, 0);
+}
+
+bool LCD_initShiftRegChain(struct LCD *this, struct LCDChain *chain, uint8_t index)
+{
+    if (index >= chain->count)
+        return false;
+
+    initShiftReg(this, LCD_SR_CHAIN, chain->port, chain->data, chain->clock, chain->strobe);
+
+    this->i.sri.chain = chain;
+    this->i.sri.index = index;
+    this->send = &LCD_chainSend;
+    this->queued = true;
+    return true;
 }
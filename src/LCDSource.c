@@ -0,0 +1,69 @@
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// Printing from any source of characters without a RAM copy.
+#include <stdio.h>
+#include "LCDSource.h"
+
+static uint8_t stringNext(struct LCDSource *src)
+{
+    uint8_t c = src->data[src->pos];
+
+    if (c != '\0')
+        src->pos++;
+    return c;
+}
+
+static uint8_t ringNext(struct LCDSource *src)
+{
+    uint8_t c = src->data[src->pos];
+
+    if (++src->pos == src->size)
+        src->pos = 0;
+    return c;
+}
+
+void LCD_sourceString(struct LCDSource *src, const char *s)
+{
+    src->next = &stringNext;
+    src->data = (const uint8_t *)s;
+    src->pos = 0;
+}
+
+void LCD_sourceRing(struct LCDSource *src, const uint8_t *buf, uint16_t size, uint16_t start)
+{
+    src->next = &ringNext;
+    src->data = buf;
+    src->size = size;
+    src->pos = start;
+}
+
+#if defined(_EEPROMSIZE) && _EEPROMSIZE > 0
+static uint8_t eepromNext(struct LCDSource *src)
+{
+    uint8_t c = eeprom_read(src->pos);
+
+    if (c != '\0')
+        src->pos++;
+    return c;
+}
+
+void LCD_sourceEeprom(struct LCDSource *src, uint16_t addr)
+{
+    src->next = &eepromNext;
+    src->pos = addr;
+}
+#endif
+
+uint8_t LCD_printSource(struct LCD *this, struct LCDSource *src, uint8_t maxlen)
+{
+    uint8_t n, c;
+
+    for (n = 0; n < maxlen; n++) {
+        c = src->next(src);
+        if (c == '\0')
+            break;
+        LCD_write(this, c);
+    }
+    return n;
+}
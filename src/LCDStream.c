@@ -0,0 +1,46 @@
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// Pre-encoded command streams for fixed screens.
+#include <stdio.h>
+#include "LCDStream.h"
+
+#ifdef LCD_LAZY_MODES
+#define markSent(lcd, field, sent)  ((lcd)->sent = (lcd)->field)
+#else
+#define markSent(lcd, field, sent)
+#endif
+
+void LCD_playStream(struct LCD *this, const uint8_t *stream, uint16_t len)
+{
+    const uint8_t *end = stream + len;
+    uint8_t value;
+
+    while (stream < end) {
+        value = *stream++;
+        if (value != LCD_STREAM_ESCAPE) {
+            LCD_write(this, value);
+        } else if (stream == end) {
+            break;      // truncated stream, the escape has no command
+        } else if ((value = *stream++) == 0x00) {
+            LCD_write(this, LCD_STREAM_ESCAPE);
+        } else if (value == LCD_CLEARDISPLAY) {
+            LCD_clear(this);
+        } else if (value == LCD_RETURNHOME) {
+            LCD_home(this);
+        } else {
+            LCD_command(this, value);
+
+            // Keep the mode registers of the object as the LCD has them
+            if ((value & 0xE0) == LCD_FUNCTIONSET) {
+                this->displayfunction = value & 0x1F;
+            } else if ((value & 0xF8) == LCD_DISPLAYCONTROL) {
+                this->displaycontrol = value & 0x07;
+                markSent(this, displaycontrol, sentcontrol);
+            } else if ((value & 0xFC) == LCD_ENTRYMODESET) {
+                this->displaymode = value & 0x03;
+                markSent(this, displaymode, sentmode);
+            }
+        }
+    }
+}
@@ -0,0 +1,91 @@
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// Screen templates for the PIC LCD library.
+#include <stdio.h>
+#include "LCDTemplate.h"
+
+// Write a row of static text, runs of two or more blanks are skipped with
+// a cursor jump since a set address costs the same as a single character.
+static void drawRow(struct LCD *this, uint8_t row, const char *text)
+{
+    uint8_t col = 0;
+    uint8_t blanks = 0;
+    bool positioned = false;
+
+    while (*text != '\0' && col < this->cols) {
+        if (*text == ' ') {
+            blanks++;
+        } else {
+            if (!positioned || blanks > 1) {
+                LCD_setCursor(this, col, row);
+                positioned = true;
+            } else if (blanks == 1) {
+                LCD_write(this, ' ');
+            }
+            blanks = 0;
+            LCD_write(this, (uint8_t)(*text));
+        }
+        text++;
+        col++;
+    }
+}
+
+void LCD_showTemplate(struct LCD *this, const struct LCDTemplate *tpl)
+{
+    uint8_t row;
+
+    LCD_clear(this);
+
+    for (row = 0; row < tpl->numrows && row < this->numlines; row++) {
+        if (tpl->rows[row] != NULL)
+            drawRow(this, row, tpl->rows[row]);
+    }
+}
+
+void LCD_setField(struct LCD *this, const struct LCDTemplate *tpl, uint8_t id, const char *value)
+{
+    const struct LCDField *f;
+    uint8_t len, pad;
+
+    if (id >= tpl->numfields)
+        return;
+
+    f = &tpl->fields[id];
+
+    len = 0;
+    while (len < f->width && value[len] != '\0')
+        len++;
+
+    pad = f->width - len;
+
+    LCD_setCursor(this, f->col, f->row);
+
+    if (f->align == LCD_ALIGN_RIGHT) {
+        for (; pad > 0; pad--)
+            LCD_write(this, ' ');
+    }
+
+    for (; len > 0; len--) {
+        LCD_write(this, (uint8_t)(*value));
+        value++;
+    }
+
+    for (; pad > 0; pad--)
+        LCD_write(this, ' ');
+}
+
+void LCD_setFieldUInt(struct LCD *this, const struct LCDTemplate *tpl, uint8_t id, uint16_t value)
+{
+    char buf[6];
+    int8_t pos = 5;
+
+    buf[pos] = '\0';
+    do {
+        pos--;
+        buf[pos] = '0' + (value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    LCD_setField(this, tpl, id, &buf[pos]);
+}
@@ -0,0 +1,76 @@
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// Tracks the state of the LCD controller from the bytes sent to it.
+#include <stdio.h>
+#include "LCDTracker.h"
+
+// Move the address counter the way the LCD does
+static void advance(struct LCDTracker *t, struct LCD *lcd, bool increment)
+{
+    if (t->cgram) {
+        t->addr = (increment ? t->addr + 1 : t->addr - 1) & 0x3F;
+    } else if (lcd->displayfunction & LCD_2LINE) {
+        // Two lines of 40 cells at 0x00 and 0x40
+        if (increment)
+            t->addr = (t->addr == 0x27) ? 0x40 : (t->addr == 0x67) ? 0x00 : t->addr + 1;
+        else
+            t->addr = (t->addr == 0x00) ? 0x67 : (t->addr == 0x40) ? 0x27 : t->addr - 1;
+    } else {
+        // One line of 80 cells
+        if (increment)
+            t->addr = (t->addr == 0x4F) ? 0x00 : t->addr + 1;
+        else
+            t->addr = (t->addr == 0x00) ? 0x4F : t->addr - 1;
+    }
+}
+
+void LCD_initTracker(struct LCDTracker *t, struct LCD *lcd)
+{
+    // Pending mode changes would make the registers differ from the LCD
+    LCD_flushModes(lcd);
+
+    t->addr = 0;
+    t->cgram = false;
+    t->control = lcd->displaycontrol;
+    t->entry = lcd->displaymode;
+}
+
+void LCD_track(struct LCDTracker *t, struct LCD *lcd, uint8_t value, uint8_t mode)
+{
+    if (mode == DATA) {
+        advance(t, lcd, (t->entry & LCD_ENTRYLEFT) != 0);
+    } else if (value & LCD_SETDDRAMADDR) {
+        t->addr = value & 0x7F;
+        t->cgram = false;
+    } else if (value & LCD_SETCGRAMADDR) {
+        t->addr = value & 0x3F;
+        t->cgram = true;
+    } else if (value & LCD_FUNCTIONSET) {
+        // Nothing to track
+    } else if (value & LCD_CURSORSHIFT) {
+        if (!(value & LCD_DISPLAYMOVE))
+            advance(t, lcd, (value & LCD_MOVERIGHT) != 0);
+    } else if (value & LCD_DISPLAYCONTROL) {
+        t->control = value & 0x07;
+    } else if (value & LCD_ENTRYMODESET) {
+        t->entry = value & 0x03;
+    } else if (value & (LCD_RETURNHOME | LCD_CLEARDISPLAY)) {
+        t->addr = 0;
+        t->cgram = false;
+        if (value == LCD_CLEARDISPLAY)
+            t->entry |= LCD_ENTRYLEFT;  // clear also sets the increment mode
+    }
+}
+
+uint8_t LCD_cellIndex(struct LCD *lcd, uint8_t addr)
+{
+    uint8_t row, base;
+
+    for (row = 0; row < lcd->numlines; row++) {
+        base = LCD_rowAddress(lcd, row);
+        if (addr >= base && addr < base + lcd->cols)
+            return row * lcd->cols + (addr - base);
+    }
+    return 0xFF;
+}
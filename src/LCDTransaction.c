@@ -0,0 +1,153 @@
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// Atomic display updates for multi-task firmware.
+#include <stdio.h>
+#include "LCDTransaction.h"
+
+static void acquire(const struct LCDLock *lock)
+{
+    if (lock != NULL)
+        lock->acquire(lock->ctx);
+}
+
+static void release(const struct LCDLock *lock)
+{
+    if (lock != NULL)
+        lock->release(lock->ctx);
+}
+
+// The changed bits from mine, the others from live
+static uint8_t merge(uint8_t live, uint8_t mine, uint8_t changed)
+{
+    return (live & ~changed) | (mine & changed);
+}
+
+// Record the mode bits a command changes
+static void touch(struct LCDTransaction *tx, uint8_t value)
+{
+    if ((value & 0xE0) == LCD_FUNCTIONSET)
+        tx->changedfunction |= (value & 0x1F) ^ tx->basefunction;
+    else if ((value & 0xF8) == LCD_DISPLAYCONTROL)
+        tx->changedcontrol |= (value & 0x07) ^ tx->basecontrol;
+    else if ((value & 0xFC) == LCD_ENTRYMODESET)
+        tx->changedmode |= (value & 0x03) ^ tx->basemode;
+}
+
+#ifdef LCD_LAZY_MODES
+#define markSent(lcd, field, sent)  ((lcd)->sent = (lcd)->field)
+#else
+#define markSent(lcd, field, sent)
+#endif
+
+// Send the recorded bytes, the lock must be held. A mode command sets the
+// bits changed by the transaction and keeps the live value of the others.
+static void replay(struct LCDTransaction *tx)
+{
+    struct LCD *lcd = tx->lcd;
+    const uint8_t *p = tx->buf;
+    const uint8_t *end = p + tx->len;
+    uint8_t value;
+
+    while (p < end) {
+        value = *p++;
+        if (value != LCD_STREAM_ESCAPE) {
+            LCD_write(lcd, value);
+        } else if ((value = *p++) == 0x00) {
+            LCD_write(lcd, LCD_STREAM_ESCAPE);
+        } else if ((value & 0xE0) == LCD_FUNCTIONSET) {
+            lcd->displayfunction = merge(lcd->displayfunction, value, tx->changedfunction);
+            LCD_command(lcd, LCD_FUNCTIONSET | lcd->displayfunction);
+        } else if ((value & 0xF8) == LCD_DISPLAYCONTROL) {
+            lcd->displaycontrol = merge(lcd->displaycontrol, value, tx->changedcontrol);
+            LCD_command(lcd, LCD_DISPLAYCONTROL | lcd->displaycontrol);
+            markSent(lcd, displaycontrol, sentcontrol);
+        } else if ((value & 0xFC) == LCD_ENTRYMODESET) {
+            lcd->displaymode = merge(lcd->displaymode, value, tx->changedmode);
+            LCD_command(lcd, LCD_ENTRYMODESET | lcd->displaymode);
+            markSent(lcd, displaymode, sentmode);
+        } else if (value == LCD_CLEARDISPLAY) {
+            LCD_clear(lcd);
+        } else if (value == LCD_RETURNHOME) {
+            LCD_home(lcd);
+        } else {
+            LCD_command(lcd, value);
+        }
+    }
+    tx->len = 0;
+}
+
+static void txSend(struct LCD *view, uint8_t value, uint8_t mode)
+{
+    struct LCDTransaction *tx = (struct LCDTransaction *)view;
+
+    if (tx->len + 2 > tx->size) {
+        // Full, send what we have and keep the lock until the commit
+        if (!tx->locked) {
+            acquire(tx->lock);
+            tx->locked = true;
+        }
+        replay(tx);
+    }
+
+    if (mode == COMMAND) {
+        touch(tx, value);
+        tx->buf[tx->len++] = LCD_STREAM_ESCAPE;
+        tx->buf[tx->len++] = value;
+    } else if (value == LCD_STREAM_ESCAPE) {
+        tx->buf[tx->len++] = LCD_STREAM_ESCAPE;
+        tx->buf[tx->len++] = 0x00;
+    } else {
+        tx->buf[tx->len++] = value;
+    }
+}
+
+void LCD_beginTransaction(struct LCDTransaction *tx, struct LCD *lcd, const struct LCDLock *lock, uint8_t *buf, uint8_t size)
+{
+    tx->lcd = lcd;
+    tx->lock = lock;
+    tx->buf = buf;
+    tx->size = size;
+    tx->len = 0;
+    tx->locked = false;
+
+    // Take a consistent copy of the mode registers, the base is taken from
+    // the copy as the LCD may change once the lock is released
+    acquire(lock);
+    tx->view = *lcd;
+    release(lock);
+
+    tx->basefunction = tx->view.displayfunction;
+    tx->basecontrol = tx->view.displaycontrol;
+    tx->basemode = tx->view.displaymode;
+    tx->changedfunction = 0;
+    tx->changedcontrol = 0;
+    tx->changedmode = 0;
+
+    tx->view.send = &txSend;
+    tx->view.queued = true;     // nothing reaches the bus, don't wait
+    tx->view.hook = NULL;
+    tx->view.read = NULL;
+}
+
+void LCD_commit(struct LCDTransaction *tx)
+{
+    struct LCD *lcd = tx->lcd;
+
+    if (!tx->locked)
+        acquire(tx->lock);
+
+    replay(tx);
+
+    // Changes not sent yet, e.g. with LCD_LAZY_MODES
+    tx->changedfunction |= tx->view.displayfunction ^ tx->basefunction;
+    tx->changedcontrol |= tx->view.displaycontrol ^ tx->basecontrol;
+    tx->changedmode |= tx->view.displaymode ^ tx->basemode;
+
+    lcd->displayfunction = merge(lcd->displayfunction, tx->view.displayfunction, tx->changedfunction);
+    lcd->displaycontrol = merge(lcd->displaycontrol, tx->view.displaycontrol, tx->changedcontrol);
+    lcd->displaymode = merge(lcd->displaymode, tx->view.displaymode, tx->changedmode);
+
+    release(tx->lock);
+    tx->locked = false;
+}
@@ -0,0 +1,257 @@
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// UTF-8 text output for the PIC LCD library.
+#include <stdio.h>
+#include "LCDUtf8.h"
+
+#define REPLACEMENT_CHAR    0xFFFD
+
+struct RomMap {
+    uint16_t cp;
+    uint8_t code;
+};
+
+struct Glyph {
+    uint16_t cp;
+    uint8_t fallback;   // Written when no CGRAM slot is available
+    uint8_t rows[8];
+};
+
+#ifndef LCD_ROM_A02
+// Code points outside ASCII available on the A00 ROM, sorted by code point.
+static const struct RomMap romMap[] = {
+    { 0x00A2, 0xEC },   // cent
+    { 0x00A3, 0xED },   // pound
+    { 0x00A5, 0x5C },   // yen
+    { 0x00B0, 0xDF },   // degree
+    { 0x00B5, 0xE4 },   // micro
+    { 0x00B7, 0xA5 },   // middle dot
+    { 0x00DF, 0xE2 },   // sharp s (beta glyph)
+    { 0x00E4, 0xE1 },   // a umlaut
+    { 0x00F1, 0xEE },   // n tilde
+    { 0x00F6, 0xEF },   // o umlaut
+    { 0x00F7, 0xFD },   // division
+    { 0x00FC, 0xF5 },   // u umlaut
+    { 0x03A3, 0xF6 },   // capital sigma
+    { 0x03A9, 0xF4 },   // omega
+    { 0x03B1, 0xE0 },   // alpha
+    { 0x03B2, 0xE2 },   // beta
+    { 0x03B5, 0xE3 },   // epsilon
+    { 0x03B8, 0xF2 },   // theta
+    { 0x03BC, 0xE4 },   // mu
+    { 0x03C0, 0xF7 },   // pi
+    { 0x03C1, 0xE6 },   // rho
+    { 0x03C3, 0xE5 },   // sigma
+    { 0x2190, 0x7F },   // left arrow
+    { 0x2192, 0x7E },   // right arrow
+    { 0x221A, 0xE8 },   // square root
+    { 0x221E, 0xF3 },   // infinity
+    { 0x2588, 0xFF },   // full block
+    { 0x4E07, 0xFB },   // man (ten thousand)
+    { 0x5186, 0xFC },   // yen (kanji)
+    { 0x5343, 0xFA },   // sen (thousand)
+};
+#endif
+
+// Built-in font for characters missing on the ROM, sorted by code point.
+static const struct Glyph font[] = {
+    { 0x005C, '|', { 0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00, 0x00 } },
+    { 0x007E, '-', { 0x00, 0x00, 0x08, 0x15, 0x02, 0x00, 0x00, 0x00 } },
+    { 0x00A1, '!', { 0x04, 0x00, 0x04, 0x04, 0x04, 0x04, 0x04, 0x00 } },
+    { 0x00BF, '?', { 0x04, 0x00, 0x04, 0x08, 0x10, 0x11, 0x0E, 0x00 } },
+    { 0x00C1, 'A', { 0x02, 0x04, 0x0E, 0x11, 0x1F, 0x11, 0x11, 0x00 } },
+    { 0x00C4, 'A', { 0x0A, 0x00, 0x0E, 0x11, 0x1F, 0x11, 0x11, 0x00 } },
+    { 0x00C9, 'E', { 0x02, 0x04, 0x1F, 0x10, 0x1E, 0x10, 0x1F, 0x00 } },
+    { 0x00CD, 'I', { 0x02, 0x04, 0x0E, 0x04, 0x04, 0x04, 0x0E, 0x00 } },
+    { 0x00D1, 'N', { 0x0D, 0x12, 0x11, 0x19, 0x15, 0x13, 0x11, 0x00 } },
+    { 0x00D3, 'O', { 0x02, 0x04, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x00 } },
+    { 0x00D6, 'O', { 0x0A, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x00 } },
+    { 0x00DA, 'U', { 0x02, 0x04, 0x11, 0x11, 0x11, 0x11, 0x0E, 0x00 } },
+    { 0x00DC, 'U', { 0x0A, 0x00, 0x11, 0x11, 0x11, 0x11, 0x0E, 0x00 } },
+    { 0x00E1, 'a', { 0x02, 0x04, 0x0E, 0x01, 0x0F, 0x11, 0x0F, 0x00 } },
+    { 0x00E9, 'e', { 0x02, 0x04, 0x0E, 0x11, 0x1F, 0x10, 0x0E, 0x00 } },
+    { 0x00ED, 'i', { 0x02, 0x04, 0x00, 0x0C, 0x04, 0x04, 0x0E, 0x00 } },
+    { 0x00F3, 'o', { 0x02, 0x04, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x00 } },
+    { 0x00FA, 'u', { 0x02, 0x04, 0x11, 0x11, 0x11, 0x13, 0x0D, 0x00 } },
+    { 0x20AC, 'E', { 0x06, 0x09, 0x1C, 0x08, 0x1C, 0x09, 0x06, 0x00 } },
+};
+
+#define FONT_SIZE   (sizeof(font) / sizeof(font[0]))
+
+// Decode the next code point and advance the string pointer. Only the
+// Basic Multilingual Plane is supported, anything else is decoded as the
+// replacement character.
+static uint16_t nextCodePoint(const char **s)
+{
+    const uint8_t *p = (const uint8_t *)(*s);
+    uint16_t cp;
+    uint8_t n;
+
+    if (*p < 0x80) {
+        cp = *p;
+        n = 0;
+    } else if ((*p & 0xE0) == 0xC0) {
+        cp = *p & 0x1F;
+        n = 1;
+    } else if ((*p & 0xF0) == 0xE0) {
+        cp = *p & 0x0F;
+        n = 2;
+    } else {
+        // 4 byte sequence or stray continuation byte, the continuation
+        // bytes are skipped below without being decoded
+        cp = REPLACEMENT_CHAR;
+        n = 0;
+    }
+    p++;
+
+    while (n > 0 && (*p & 0xC0) == 0x80) {
+        cp = (cp << 6) | (*p & 0x3F);
+        p++;
+        n--;
+    }
+
+    if (n != 0)
+        cp = REPLACEMENT_CHAR;
+
+    // Skip the trailing bytes of unsupported sequences
+    if (cp == REPLACEMENT_CHAR) {
+        while ((*p & 0xC0) == 0x80)
+            p++;
+    }
+
+    *s = (const char *)p;
+    return cp;
+}
+
+// Returns the ROM code of a code point, 0 if the ROM doesn't have it
+// (0 is a CGRAM code, so it can't be a valid result).
+static uint8_t romCode(uint16_t cp)
+{
+#ifndef LCD_ROM_A02
+    uint8_t i;
+
+    if (cp >= 0x20 && cp <= 0x7D && cp != '\\')
+        return (uint8_t)cp;
+
+    // Halfwidth katakana are laid out in the same order as the ROM
+    if (cp >= 0xFF61 && cp <= 0xFF9F)
+        return (uint8_t)(0xA1 + (cp - 0xFF61));
+
+    for (i = 0; i < sizeof(romMap) / sizeof(romMap[0]) && romMap[i].cp <= cp; i++) {
+        if (romMap[i].cp == cp)
+            return romMap[i].code;
+    }
+#else
+    if (cp >= 0x20 && cp <= 0x7E)
+        return (uint8_t)cp;
+
+    // Latin-1 letters are in their ISO 8859-1 position, except for the
+    // cells where the A02 ROM has Greek letters instead.
+    if (cp >= 0xC0 && cp <= 0xFF && (cp & 0xDF) != 0xD7 && (cp & 0xDF) != 0xD8)
+        return (uint8_t)cp;
+#endif
+    return 0;
+}
+
+static const struct Glyph *findGlyph(uint16_t cp)
+{
+    uint8_t i;
+
+    for (i = 0; i < FONT_SIZE && font[i].cp <= cp; i++) {
+        if (font[i].cp == cp)
+            return &font[i];
+    }
+    return NULL;
+}
+
+// Returns the slot holding the code point, or 0xFF
+static uint8_t findSlot(struct LCDGlyphCache *cache, uint16_t cp)
+{
+    uint8_t slot;
+
+    for (slot = cache->first; slot < cache->first + cache->count; slot++) {
+        if (cache->glyph[slot] == cp)
+            return slot;
+    }
+    return 0xFF;
+}
+
+static void uploadGlyph(struct LCD *this, uint8_t slot, const struct Glyph *g)
+{
+    uint8_t i;
+
+    LCD_command(this, LCD_SETCGRAMADDR | (slot << 3));
+    for (i = 0; i < 8; i++)
+        LCD_write(this, g->rows[i]);
+}
+
+void LCD_initGlyphCache(struct LCDGlyphCache *cache, uint8_t first, uint8_t count)
+{
+    uint8_t i;
+
+    first &= 0x7;
+    if (count > 8 - first)
+        count = 8 - first;
+
+    for (i = 0; i < 8; i++)
+        cache->glyph[i] = 0;
+
+    cache->first = first;
+    cache->count = count;
+    cache->next = first;
+}
+
+void LCD_printUtf8(struct LCD *this, struct LCDGlyphCache *cache, uint8_t col, uint8_t row, const char *s)
+{
+    const struct Glyph *g;
+    const char *p;
+    uint16_t cp;
+    uint8_t slot, code, used, tries;
+
+    // First pass, load the missing glyphs while the cursor position doesn't
+    // matter yet.
+    used = 0;
+    p = s;
+    while (*p != '\0') {
+        cp = nextCodePoint(&p);
+        if (romCode(cp) != 0 || (g = findGlyph(cp)) == NULL)
+            continue;
+
+        slot = findSlot(cache, cp);
+        if (slot == 0xFF) {
+            // Recycle the next slot not used by this string
+            for (tries = 0; tries < cache->count; tries++) {
+                slot = cache->next;
+                cache->next++;
+                if (cache->next >= cache->first + cache->count)
+                    cache->next = cache->first;
+                if ((used & (1 << slot)) == 0)
+                    break;
+            }
+            if (tries == cache->count)
+                continue;
+
+            cache->glyph[slot] = cp;
+            uploadGlyph(this, slot, g);
+        }
+        used |= 1 << slot;
+    }
+
+    // Second pass, write the text
+    LCD_setCursor(this, col, row);
+
+    p = s;
+    while (*p != '\0') {
+        cp = nextCodePoint(&p);
+        code = romCode(cp);
+        if (code == 0) {
+            g = findGlyph(cp);
+            if (g == NULL)
+                code = '?';
+            else if ((code = findSlot(cache, cp)) == 0xFF)
+                code = g->fallback;
+        }
+        LCD_write(this, code);
+    }
+}
@@ -0,0 +1,126 @@
+// Licensed under creative commons license 3.0:
+//        Attribution-ShareAlike CC BY-SA
+//
+// Display integrity watchdog for the PIC LCD library.
+#include <stdio.h>
+#include "LCDWatchdog.h"
+
+static void watchdogSend(struct LCDHook *hook, struct LCD *lcd, uint8_t value, uint8_t mode)
+{
+    struct LCDWatchdog *wd = (struct LCDWatchdog *)hook;
+    uint8_t i;
+
+    LCD_hookForward(hook, lcd, value, mode);
+
+    if (mode == DATA) {
+        if (!wd->track.cgram && (i = LCD_cellIndex(lcd, wd->track.addr)) != 0xFF)
+            wd->shadow[i] = value;
+    } else if (value == LCD_CLEARDISPLAY) {
+        for (i = 0; i < lcd->numlines * lcd->cols; i++)
+            wd->shadow[i] = ' ';
+    }
+
+    LCD_track(&wd->track, lcd, value, mode);
+}
+
+// Put the address counter back where the application left it
+static void restoreAddress(struct LCDWatchdog *wd, struct LCD *lcd)
+{
+    if (wd->track.cgram)
+        LCD_hookForward(&wd->hook, lcd, LCD_SETCGRAMADDR | wd->track.addr, COMMAND);
+    else
+        LCD_hookForward(&wd->hook, lcd, LCD_SETDDRAMADDR | wd->track.addr, COMMAND);
+}
+
+// Re-send n cells of a row from the shadow copy. With readback only the
+// cells that differ are written.
+static void repairCells(struct LCDWatchdog *wd, struct LCD *lcd, uint8_t row, uint8_t col, uint8_t n)
+{
+    const uint8_t *p = &wd->shadow[row * lcd->cols + col];
+    uint8_t addr = LCD_rowAddress(lcd, row) + col;
+    uint8_t i;
+
+    // Cells are walked left to right without shifting the display
+    if (wd->track.entry != LCD_ENTRYLEFT)
+        LCD_hookForward(&wd->hook, lcd, LCD_ENTRYMODESET | LCD_ENTRYLEFT, COMMAND);
+
+    LCD_hookForward(&wd->hook, lcd, LCD_SETDDRAMADDR | addr, COMMAND);
+
+    for (i = 0; i < n; i++) {
+        if (lcd->read == NULL) {
+            LCD_hookForward(&wd->hook, lcd, p[i], DATA);
+        } else if (lcd->read(lcd, DATA) != p[i]) {
+            // The read moved the address counter past the cell
+            LCD_hookForward(&wd->hook, lcd, LCD_SETDDRAMADDR | (addr + i), COMMAND);
+            LCD_hookForward(&wd->hook, lcd, p[i], DATA);
+        }
+    }
+
+    if (wd->track.entry != LCD_ENTRYLEFT)
+        LCD_hookForward(&wd->hook, lcd, LCD_ENTRYMODESET | wd->track.entry, COMMAND);
+
+    restoreAddress(wd, lcd);
+}
+
+void LCD_initWatchdog(struct LCDWatchdog *wd, struct LCD *lcd, uint8_t *shadow, uint16_t budget)
+{
+    wd->shadow = shadow;
+    wd->budget = budget;
+    wd->step = 0;
+    wd->col = 0;
+
+    LCD_initTracker(&wd->track, lcd);
+    LCD_addHook(lcd, &wd->hook, &watchdogSend);
+
+    // Start from a known DDRAM content and address
+    LCD_clear(lcd);
+}
+
+void LCD_watchdogTick(struct LCDWatchdog *wd, struct LCD *lcd)
+{
+    uint16_t byte, cost, spent, fit;
+    uint8_t n;
+
+    byte = LCD_estimateCostUs(lcd, LCD_OP_WRITE, 1);
+    spent = 0;
+
+    do {
+        if (wd->step == 0) {
+            // Interface resync (the slowest case), then the registers
+            cost = LCD_RESYNC_TIME + 7 * byte;
+            if (spent != 0 && spent + cost > wd->budget)
+                break;
+
+            LCD_resync(lcd);
+            LCD_hookForward(&wd->hook, lcd, LCD_DISPLAYCONTROL | wd->track.control, COMMAND);
+            LCD_hookForward(&wd->hook, lcd, LCD_ENTRYMODESET | wd->track.entry, COMMAND);
+            restoreAddress(wd, lcd);
+
+            wd->step = 1;
+            wd->col = 0;
+        } else {
+            // Set and restore the address, plus the entry mode if needed
+            cost = (wd->track.entry != LCD_ENTRYLEFT) ? 4 * byte : 2 * byte;
+
+            n = lcd->cols - wd->col;
+            if (spent + cost + n * byte > wd->budget) {
+                fit = (wd->budget > spent + cost) ? (wd->budget - spent - cost) / byte : 0;
+                if (fit == 0 && spent != 0)
+                    break;
+                if (fit < n)
+                    n = (fit != 0) ? fit : 1;
+            }
+
+            repairCells(wd, lcd, wd->step - 1, wd->col, n);
+            cost += n * byte;
+
+            wd->col += n;
+            if (wd->col >= lcd->cols) {
+                wd->col = 0;
+                wd->step = (wd->step < lcd->numlines) ? wd->step + 1 : 0;
+            }
+        }
+
+        spent += cost;
+    } while (spent < wd->budget);
+}